@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+#include "number_theory.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BINOMIAL_TABLE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binomial coefficients C(n, k) = n! / (k! * (n - k)!) modulo a prime p
+// (https://en.wikipedia.org/wiki/Binomial_coefficient).
+// The table stores i! % p and (i!)^-1 % p for all i < size, so C(n, k) = n! * (k!)^-1 * ((n - k)!)^-1 is the product
+// of three table entries, i.e. two Barrett multiplications instead of O(k) multiplications and an inversion.
+// The factorials are prefix products, i! = (i - 1)! * i. The inverse factorials only need the inversion of the
+// largest factorial, since (i!)^-1 = ((i + 1)!)^-1 * (i + 1). So the table is built with 2 * size multiplications
+// and one mod_inverse.
+// Since p divides i! for i >= p, the table ends at p - 1. For n >= p, Lucas' theorem
+// (https://en.wikipedia.org/wiki/Lucas%27s_theorem) splits n and k into digits in base p:
+// C(n, k) == C(n_0, k_0) * C(n_1, k_1) * ... (mod p), which needs a table up to p - 1. Queries which need a larger
+// table than the one which was built return std::nullopt.
+// The table can be saved to a file and mapped into memory, so a large table is available without rebuilding it.
+class BinomialTable
+{
+public:
+    // Builds the table for all n <= max_n (and n < p) modulo p, or returns std::nullopt if p is not a prime.
+    // The prefix products are split into threads chunks: every thread computes the products within its chunk,
+    // the products of the previous chunks are accumulated serially, and every thread scales its chunk with them.
+    // By default, all hardware threads are used for tables with at least 2^16 entries.
+    static std::optional<BinomialTable> create(uint64_t p, uint64_t max_n, size_t threads = std::thread::hardware_concurrency())
+    {
+        if (!is_prime(p))
+        {
+            return std::nullopt;
+        }
+        return BinomialTable(p, max_n, threads);
+    }
+
+    uint64_t modulus() const
+    {
+        return p;
+    }
+
+    // Returns the number of factorials in the table, C(n, k) is looked up directly for n < size().
+    size_t size() const
+    {
+        return table_size;
+    }
+
+    // Returns n! % p for n < size().
+    uint64_t factorial(uint64_t n) const
+    {
+        assert(n < table_size);
+        return factorials[n];
+    }
+
+    // Returns (n!)^-1 % p for n < size().
+    uint64_t inverse_factorial(uint64_t n) const
+    {
+        assert(n < table_size);
+        return inverse_factorials[n];
+    }
+
+    // Returns C(n, k) % p, which is 0 for k > n.
+    // n >= size() requires a table up to p - 1, which is used for every digit of Lucas' theorem. Returns std::nullopt
+    // if the table is smaller.
+    std::optional<uint64_t> binomial(uint64_t n, uint64_t k) const
+    {
+        if (k > n)
+        {
+            return 0;
+        }
+        if (n < table_size)
+        {
+            return lookup(n, k);
+        }
+        if (table_size != p)
+        {
+            return std::nullopt;
+        }
+
+        uint64_t result = 1;
+        while (n > 0 && result != 0)
+        {
+            const uint64_t n_digit = n % p;
+            const uint64_t k_digit = k % p;
+            result = k_digit > n_digit ? 0 : barrett.multiply(result, lookup(n_digit, k_digit));
+            n /= p;
+            k /= p;
+        }
+        return result;
+    }
+
+    // Writes the table to the file at path, which can be mapped with map_file. Returns false on failure.
+    // The file contains a header (magic number, p and size) and both arrays in the byte order of the machine.
+    bool save(const std::string &path) const
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const uint64_t header[] = {file_magic, p, table_size};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(factorials), table_size * sizeof(uint64_t));
+        file.write(reinterpret_cast<const char *>(inverse_factorials), table_size * sizeof(uint64_t));
+        return static_cast<bool>(file);
+    }
+
+#if defined(BINOMIAL_TABLE_MMAP)
+    // Maps a table written by save into memory, or returns std::nullopt if the file is missing or no valid table.
+    // The pages are only read from disk when they are accessed, so the startup time does not depend on the size.
+    // The mapping stays valid as long as a copy of the table exists.
+    static std::optional<BinomialTable> map_file(const std::string &path)
+    {
+        const int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            return std::nullopt;
+        }
+        struct stat status;
+        const bool has_size = fstat(descriptor, &status) == 0 && status.st_size >= static_cast<off_t>(3 * sizeof(uint64_t));
+        const size_t file_size = has_size ? static_cast<size_t>(status.st_size) : 0;
+        void *address = has_size ? mmap(nullptr, file_size, PROT_READ, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+        close(descriptor);
+        if (address == MAP_FAILED)
+        {
+            return std::nullopt;
+        }
+        std::shared_ptr<const void> mapping(address, [file_size](const void *a)
+                                            { munmap(const_cast<void *>(a), file_size); });
+
+        const uint64_t *header = static_cast<const uint64_t *>(address);
+        const uint64_t p = header[1];
+        const uint64_t size = header[2];
+        if (header[0] != file_magic || !is_prime(p) || size == 0 || size > p || size > (file_size - 3 * sizeof(uint64_t)) / (2 * sizeof(uint64_t)) ||
+            file_size != (3 + 2 * size) * sizeof(uint64_t))
+        {
+            return std::nullopt;
+        }
+        BinomialTable table(p, size, header + 3, header + 3 + size, std::move(mapping));
+        // A cheap consistency check of the largest entries.
+        if (table.factorials[size - 1] >= p || mod_multiply(table.factorials[size - 1], table.inverse_factorials[size - 1] % p, p) != 1)
+        {
+            return std::nullopt;
+        }
+        return table;
+    }
+#endif
+
+private:
+    // Returns C(n, k) % p for k <= n < size().
+    uint64_t lookup(uint64_t n, uint64_t k) const
+    {
+        return barrett.multiply(barrett.multiply(factorials[n], inverse_factorials[k]), inverse_factorials[n - k]);
+    }
+
+    // "BINOMTB1" in little endian.
+    static constexpr uint64_t file_magic = 0x3142544d4f4e4942UL;
+
+    // Builds the table for the prime p, see create.
+    BinomialTable(uint64_t p, uint64_t max_n, size_t threads)
+        : p(p), table_size(std::min(max_n, p - 1) + 1), barrett(p)
+    {
+        assert(p > 1);
+
+        // Not initialized, the pages are touched first by the thread which computes them.
+        owned.reset(new uint64_t[2 * table_size]);
+        factorials = owned.get();
+        inverse_factorials = factorials + table_size;
+        threads = table_size < (1 << 16) ? 1 : std::max<size_t>(1, std::min<size_t>(threads, table_size));
+
+        const size_t chunk = (table_size + threads - 1) / threads;
+        const auto run = [threads](const auto &function)
+        {
+            if (threads == 1)
+            {
+                function(0);
+                return;
+            }
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < threads; t++)
+            {
+                workers.emplace_back(function, t);
+            }
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        };
+        const auto begin = [&](size_t t)
+        { return std::min(t * chunk, table_size); };
+        const auto end = [&](size_t t)
+        { return std::min((t + 1) * chunk, table_size); };
+        uint64_t *factorial = owned.get();
+        uint64_t *inverse_factorial = factorial + table_size;
+
+        // Within the chunk: factorial[i] = begin * (begin + 1) * ... * i, inverse_factorial[i] = (i + 1) * ... * (end - 1).
+        // Both are chains of dependent multiplications, which are interleaved to overlap their latencies.
+        run([&](size_t t)
+            {
+                const size_t b = begin(t);
+                const size_t e = end(t);
+                if (b == e)
+                {
+                    return;
+                }
+                factorial[b] = b == 0 ? 1 : b;
+                inverse_factorial[e - 1] = 1;
+                for (size_t i = b + 1, j = e - 1; i < e; i++, j--)
+                {
+                    factorial[i] = barrett.multiply(factorial[i - 1], i);
+                    inverse_factorial[j - 1] = barrett.multiply(inverse_factorial[j], j);
+                } });
+
+        // prefix[t] = (begin(t) - 1)!, suffix[t] = end(t) * ... * (size - 1).
+        std::vector<uint64_t> prefix(threads, 1);
+        std::vector<uint64_t> suffix(threads, 1);
+        for (size_t t = 1; t < threads; t++)
+        {
+            prefix[t] = begin(t) > begin(t - 1) ? barrett.multiply(prefix[t - 1], factorial[begin(t) - 1]) : prefix[t - 1];
+        }
+        for (size_t t = threads - 1; t > 0; t--)
+        {
+            // The product of all numbers in chunk t is begin(t) * suffix within the chunk.
+            suffix[t - 1] = begin(t) < end(t) ? barrett.multiply(suffix[t], barrett.multiply(inverse_factorial[begin(t)], begin(t))) : suffix[t];
+        }
+        // p is a prime and all factors are smaller than p, so the product is invertible.
+        const uint64_t largest = barrett.multiply(prefix[(table_size - 1) / chunk], factorial[table_size - 1]);
+        const uint64_t largest_inverse = mod_multiplicative_inverse(largest, p);
+
+        run([&](size_t t)
+            {
+                const uint64_t scale = barrett.multiply(suffix[t], largest_inverse);
+                for (size_t i = begin(t); i < end(t); i++)
+                {
+                    inverse_factorial[i] = barrett.multiply(inverse_factorial[i], scale);
+                }
+                // The first chunk starts with 0!, so its factorials are complete.
+                for (size_t i = begin(t); t > 0 && i < end(t); i++)
+                {
+                    factorial[i] = barrett.multiply(factorial[i], prefix[t]);
+                } });
+    }
+
+    BinomialTable(uint64_t p, size_t size, const uint64_t *factorials, const uint64_t *inverse_factorials, std::shared_ptr<const void> mapping)
+        : p(p), table_size(size), barrett(p), factorials(factorials), inverse_factorials(inverse_factorials), mapping(std::move(mapping))
+    {
+    }
+
+    uint64_t p;
+    size_t table_size;
+    BarrettReducer barrett;
+    const uint64_t *factorials = nullptr;
+    const uint64_t *inverse_factorials = nullptr;
+    // The storage of the arrays, either owned or mapped from a file.
+    std::shared_ptr<uint64_t[]> owned;
+    std::shared_ptr<const void> mapping;
+};
@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <assert.h>
+
+#include "binomial_table.h"
+
+// This code shows how to compute binomial coefficients modulo a prime with a BinomialTable.
+// The table is implemented in binomial_table.h.
+
+int main(int argc, char **argv)
+{
+    const uint64_t p = 1000000007;
+    const BinomialTable table = BinomialTable::create(p, 1000000).value();
+    std::cout << "C(1000000, 500000) % " << p << " = " << *table.binomial(1000000, 500000) << std::endl;
+    assert(table.binomial(1000000, 500000) == 996692777);
+    assert(table.binomial(10, 3) == 120 && table.binomial(3, 10) == 0);
+    // n >= size() needs Lucas' theorem and a table up to p - 1, and p has to be a prime.
+    assert(!table.binomial(2000000, 3));
+    assert(!BinomialTable::create(1000000008, 1000));
+
+    // Lucas' theorem for n >= p with the full table of p = 13, compared to Pascal's triangle modulo 13.
+    const BinomialTable small = BinomialTable::create(13, 12).value();
+    std::vector<std::vector<uint64_t>> pascal(1001, std::vector<uint64_t>(1001, 0));
+    for (size_t n = 0; n <= 1000; n++)
+    {
+        pascal[n][0] = 1;
+        for (size_t k = 1; k <= n; k++)
+        {
+            pascal[n][k] = (pascal[n - 1][k - 1] + pascal[n - 1][k]) % 13;
+        }
+    }
+    for (size_t k = 0; k <= 1000; k++)
+    {
+        assert(small.binomial(1000, k) == pascal[1000][k]);
+    }
+    std::cout << "C(1000, 300) % 13 = " << *small.binomial(1000, 300) << ", C(1000, 299) % 13 = " << *small.binomial(1000, 299) << std::endl;
+
+#if defined(BINOMIAL_TABLE_MMAP)
+    // Save the table and map it back into memory.
+    const std::string path = (std::filesystem::temp_directory_path() / "binomial_table_main.bin").string();
+    const bool saved = table.save(path);
+    assert(saved);
+    const std::optional<BinomialTable> mapped = saved ? BinomialTable::map_file(path) : std::nullopt;
+    assert(mapped);
+    if (mapped)
+    {
+        assert(mapped->size() == table.size());
+        std::cout << "Mapped from " << path << ": C(1000000, 500000) % " << p << " = " << *mapped->binomial(1000000, 500000) << std::endl;
+        assert(mapped->binomial(1000000, 500000) == table.binomial(1000000, 500000));
+    }
+    std::remove(path.c_str());
+#endif
+}
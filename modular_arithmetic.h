@@ -0,0 +1,1502 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+// This code shows how to do modular arithmetic in C++ (https://en.wikipedia.org/wiki/Modular_arithmetic).
+
+// In the following, we assume that the input to the functions is valid, meaning is an element of Z_n.
+// Therefore, the modulo operator is the special case of the euclidean reminder for values where a >= 0 and b > 0.
+// This allows us to use just the modulo operator "%" to perform the modulo operation.
+
+// This function computes the euclidean reminder for values where n > 0.
+// It allows to convert any value (even negative) into the space Z_n.
+constexpr inline uint64_t mod(int64_t a, int64_t n)
+{
+    assert(n > 0);
+    return ((a % n) + n) % n;
+}
+
+// This function computes the euclidean reminder for values where n > 0 and a > 0.
+// It allows to convert positive values into the space Z_n.
+constexpr inline uint64_t mod_pos(uint64_t a, uint64_t n)
+{
+    assert(n > 0);
+    return a % n;
+}
+
+// This function computes (a + b) % n.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+constexpr inline uint64_t mod_add(uint64_t a, uint64_t b, uint64_t n)
+{
+    assert(a < n);
+    assert(b < n);
+    assert(n > 0);
+
+    if (b == 0)
+        return a;
+
+    // Returns mod_minus(a, m-b, m);
+    b = n - b;
+    if (a >= b)
+        return a - b;
+    else
+        return n - b + a;
+}
+
+// This function computes (a - b) % n.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+constexpr inline uint64_t mod_subtract(uint64_t a, uint64_t b, uint64_t n)
+{
+    assert(a < n);
+    assert(b < n);
+    assert(n > 0);
+
+    if (a >= b)
+    {
+        return a - b;
+    }
+    else
+    {
+        return n - b + a;
+    }
+}
+
+// This function computes (a + 1) % n.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+constexpr inline uint64_t mod_increment(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    a++;
+    if (a == n)
+    {
+        a = 0;
+    }
+    return a;
+}
+
+// This function computes (a - 1) % n.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+constexpr inline uint64_t mod_decrement(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    if (a == 0)
+    {
+        a = n - 1;
+    }
+    else
+    {
+        a--;
+    }
+    return a;
+}
+
+// This function computes the additive inverse of a, such that:
+// mod_add(a, mod_additive_inverse(a, n), n) == 0.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+constexpr inline uint64_t mod_additive_inverse(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    if (a == 0)
+    {
+        return 0;
+    }
+    else
+    {
+        return n - a;
+    }
+}
+
+// The product in mod_multiply is computed by one of the following kernels. Each kernel provides
+// static uint64_t multiply(uint64_t a, uint64_t b, uint64_t n), which computes (a * b) % n for a, b < n.
+// DefaultMultiplyKernel is the fastest kernel for a single product with an arbitrary modulus that is available for
+// the build target, it is picked at compile time. Such a product always needs one division: a division-free reduction
+// (Barrett or Montgomery) needs a precomputed constant, whose computation is itself a 128/64 bit division. So these
+// kernels only pay off when the constant is reused: for many products with the same modulus, BarrettContext or
+// MontgomeryContext are faster than any kernel.
+
+// This kernel uses the double and add algorithm, requires O(log(a) + log(b)) time.
+// It is portable, but needs up to 128 calls of mod_add per product.
+struct DoubleAndAddKernel
+{
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b, uint64_t n)
+    {
+        uint64_t product = 0;
+        if (b > a)
+        {
+            const uint64_t t = a;
+            a = b;
+            b = t;
+        }
+
+        while (b)
+        {
+            if (b & 0x1)
+            {
+                product = mod_add(product, a, n);
+            }
+            a = mod_add(a, a, n);
+            b >>= 1;
+        }
+        return product;
+    }
+};
+
+#if defined(__SIZEOF_INT128__)
+// This kernel uses the native 128 bit integer of GCC and Clang.
+// The compiler emits a single 64x64->128 bit multiplication, the remainder is computed by the runtime library (__umodti3).
+struct Int128Kernel
+{
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b, uint64_t n)
+    {
+        return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % n);
+    }
+};
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+// This kernel uses the x86-64 instructions directly: mul computes the 128 bit product in rdx:rax and
+// div divides rdx:rax by n. GCC and Clang have no intrinsic for the 128/64 bit division, therefore inline assembly is used.
+// The division does not trap, since a, b < n implies that the upper half of the product is smaller than n.
+// divq is kept deliberately: it costs about as much as a Barrett reduction with a cached reciprocal (3.9 against
+// 3.8 ns/op in modular_arithmetic_benchmark_main), and computing the reciprocal per call would add a second division.
+// mulx instead of mulq would not help either, the full product is already a single instruction.
+struct IntrinsicKernel
+{
+    static uint64_t multiply(uint64_t a, uint64_t b, uint64_t n)
+    {
+        uint64_t low;
+        uint64_t high;
+        __asm__("mulq %3"
+                : "=a"(low), "=d"(high)
+                : "a"(a), "rm"(b)
+                : "cc");
+        uint64_t quotient;
+        uint64_t remainder;
+        __asm__("divq %4"
+                : "=a"(quotient), "=d"(remainder)
+                : "a"(low), "d"(high), "rm"(n)
+                : "cc");
+        return remainder;
+    }
+};
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+using DefaultMultiplyKernel = IntrinsicKernel;
+#elif defined(__SIZEOF_INT128__)
+using DefaultMultiplyKernel = Int128Kernel;
+#else
+using DefaultMultiplyKernel = DoubleAndAddKernel;
+#endif
+
+// This function computes (a * b) % n.
+// In constant expressions, the portable kernels are used, since inline assembly can not be evaluated at compile time.
+template <class Kernel = DefaultMultiplyKernel>
+constexpr inline uint64_t mod_multiply(uint64_t a, uint64_t b, uint64_t n)
+{
+    assert(a < n);
+    assert(b < n);
+    assert(n > 0);
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_is_constant_evaluated())
+    {
+#if defined(__SIZEOF_INT128__)
+        return Int128Kernel::multiply(a, b, n);
+#else
+        return DoubleAndAddKernel::multiply(a, b, n);
+#endif
+    }
+#endif
+    return Kernel::multiply(a, b, n);
+}
+
+// This function computes (a * a) % n.
+template <class Kernel = DefaultMultiplyKernel>
+constexpr inline uint64_t mod_sqr(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+    return mod_multiply<Kernel>(a, a, n);
+}
+
+// This function computes (a^e) % n.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+template <class Kernel = DefaultMultiplyKernel>
+constexpr inline uint64_t mod_power(uint64_t a, uint64_t e, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    if (e == 0)
+    {
+        return 1;
+    }
+    else
+    {
+        uint64_t z = a;
+        uint64_t y = 1;
+        while (1)
+        {
+            if (e & 0x1)
+            {
+                y = mod_multiply<Kernel>(y, z, n); // y *= z;
+            }
+            e >>= 1;
+            if (0 == e)
+            {
+                break;
+            }
+            z = mod_sqr<Kernel>(z, n); // z *= z;
+        }
+        return y;
+    }
+}
+
+// Returns the multiplicative inverse of a, such that:
+// mod_multiply(a, mod_multiplicative_inverse(a, n)) == 1.
+// Note that the multiplicative inverse only exists when n is a prime.
+template <class Kernel = DefaultMultiplyKernel>
+constexpr inline uint64_t mod_multiplicative_inverse(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+    return mod_power<Kernel>(a, n - 2, n);
+}
+
+// Returns the window width for mod_power_sliding_window for an exponent with the given number of bits.
+// A window width of k needs 2^(k-1) multiplications for the table and about bits / (k + 1) multiplications
+// for the exponent, which is minimal for the following thresholds.
+constexpr inline int sliding_window_width(int bits)
+{
+    if (bits <= 8)
+    {
+        return 1;
+    }
+    if (bits <= 24)
+    {
+        return 2;
+    }
+    if (bits <= 80)
+    {
+        return 3;
+    }
+    return 4;
+}
+
+// This function computes (a^e) % n, the same as mod_power.
+// It uses left-to-right sliding window exponentiation (https://en.wikipedia.org/wiki/Exponentiation_by_squaring#Sliding-window_method):
+// The exponent is split into windows of at most k bits that start and end with a set bit, separated by zero bits.
+// Every window needs one multiplication with a precomputed odd power a^1, a^3, ..., a^(2^k - 1) instead of one
+// multiplication per set bit. For 64 bit exponents, this saves about 15% of the multiplications of mod_power.
+// Note that all multiplications form one dependency chain. In mod_power, the squarings are independent of the
+// multiplications, so on an out of order CPU mod_power can still be faster when the multiplication is cheap.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), algorithm 14.85.
+template <class Kernel = DefaultMultiplyKernel>
+constexpr inline uint64_t mod_power_sliding_window(uint64_t a, uint64_t e, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    if (e == 0)
+    {
+        return 1;
+    }
+
+    int bits = 0;
+    while ((e >> bits) > 1)
+    {
+        bits++;
+    }
+    bits++;
+    const int k = sliding_window_width(bits);
+
+    // odd_powers[i] = a^(2 * i + 1), 8 entries are enough for k <= 4.
+    uint64_t odd_powers[8] = {};
+    odd_powers[0] = a;
+    if (k > 1)
+    {
+        const uint64_t a_squared = mod_sqr<Kernel>(a, n);
+        for (int i = 1; i < (1 << (k - 1)); i++)
+        {
+            odd_powers[i] = mod_multiply<Kernel>(odd_powers[i - 1], a_squared, n);
+        }
+    }
+
+    uint64_t y = 1;
+    bool first = true;
+    int i = bits - 1;
+    while (i >= 0)
+    {
+        if (((e >> i) & 0x1) == 0)
+        {
+            y = mod_sqr<Kernel>(y, n);
+            i--;
+            continue;
+        }
+
+        // The window covers the bits i, ..., j, where j is the lowest set bit within the next k bits.
+        int j = i - k + 1 < 0 ? 0 : i - k + 1;
+        while (((e >> j) & 0x1) == 0)
+        {
+            j++;
+        }
+        const uint64_t window = (e >> j) & ((1UL << (i - j + 1)) - 1);
+        if (first)
+        {
+            y = odd_powers[window >> 1];
+            first = false;
+        }
+        else
+        {
+            for (int s = 0; s < i - j + 1; s++)
+            {
+                y = mod_sqr<Kernel>(y, n);
+            }
+            y = mod_multiply<Kernel>(y, odd_powers[window >> 1], n);
+        }
+        i = j - 1;
+    }
+    return y;
+}
+
+// FixedBasePower computes (a^e) % n for a fixed base a and modulus n, but varying exponents e.
+// The exponent is split into digits of w bits: e = sum(d_i * 2^(w * i)), so a^e = prod(a^(d_i * 2^(w * i))).
+// All factors a^(d * 2^(w * i)) are precomputed, so an exponentiation needs one multiplication per non-zero digit,
+// i.e. about log(e) / w multiplications and no squarings.
+// The table has ceil(64 / w) * 2^w entries (e.g. 16 KiB for w = 8), so w trades memory for latency.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), chapter 14.6.3.
+template <class Kernel = DefaultMultiplyKernel>
+class FixedBasePower
+{
+public:
+    FixedBasePower(uint64_t a, uint64_t n, int window_bits = 8)
+        : n(n), window_bits(window_bits), digits((64 + window_bits - 1) / window_bits)
+    {
+        assert(a < n);
+        assert(n > 0);
+        assert(window_bits >= 1 && window_bits <= 16);
+
+        const size_t digit_count = static_cast<size_t>(1) << window_bits;
+        table.resize(digits * digit_count);
+        // base = a^(2^(w * i)) for the current digit position i.
+        uint64_t base = a;
+        for (int i = 0; i < digits; i++)
+        {
+            uint64_t *row = &table[i * digit_count];
+            row[0] = 1;
+            for (size_t d = 1; d < digit_count; d++)
+            {
+                row[d] = mod_multiply<Kernel>(row[d - 1], base, n);
+            }
+            base = mod_multiply<Kernel>(row[digit_count - 1], base, n);
+        }
+    }
+
+    uint64_t modulus() const
+    {
+        return n;
+    }
+
+    // Returns the number of precomputed powers.
+    size_t table_size() const
+    {
+        return table.size();
+    }
+
+    // This function computes (a^e) % n.
+    uint64_t power(uint64_t e) const
+    {
+        const uint64_t digit_mask = (1UL << window_bits) - 1;
+        const uint64_t *row = table.data();
+        uint64_t y = 1;
+        bool first = true;
+        while (e)
+        {
+            const uint64_t digit = e & digit_mask;
+            if (digit)
+            {
+                y = first ? row[digit] : mod_multiply<Kernel>(y, row[digit], n);
+                first = false;
+            }
+            e >>= window_bits;
+            row += digit_mask + 1;
+        }
+        return y;
+    }
+
+private:
+    uint64_t n;
+    int window_bits;
+    int digits;
+    std::vector<uint64_t> table; // table[i * 2^w + d] = a^(d * 2^(w * i))
+};
+
+// This function computes (bases[0]^exponents[0] * ... * bases[count - 1]^exponents[count - 1]) % n.
+// Instead of count calls of mod_power, it uses interleaved sliding window exponentiation (Straus' algorithm):
+// Every exponent is split into windows as in mod_power_sliding_window, but all bases share one chain of squarings.
+// For count bases, this needs about max(log(e)) squarings instead of count * log(e).
+// Note that the multiplications form one dependency chain, so the savings show when the latency of a multiplication
+// is not hidden by out of order execution, or for larger count.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), algorithm 14.88 and
+// Bodo Moeller, Algorithms for multi-exponentiation (https://doi.org/10.1007/3-540-45537-X_13).
+template <class Kernel = DefaultMultiplyKernel>
+inline uint64_t mod_multi_power(const uint64_t *bases, const uint64_t *exponents, size_t count, uint64_t n)
+{
+    assert(n > 0);
+
+    // odd_powers[8 * i + j] = bases[i]^(2 * j + 1), windows[64 * i + b] is the window of exponents[i] ending at bit b.
+    std::vector<uint64_t> odd_powers(8 * count);
+    std::vector<uint8_t> windows(64 * count, 0);
+    int max_bits = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        assert(bases[i] < n);
+        const uint64_t e = exponents[i];
+        int bits = 0;
+        while (bits < 64 && (e >> bits) != 0)
+        {
+            bits++;
+        }
+        if (bits == 0)
+        {
+            continue;
+        }
+        max_bits = bits > max_bits ? bits : max_bits;
+        const int k = sliding_window_width(bits);
+
+        uint64_t *powers = &odd_powers[8 * i];
+        powers[0] = bases[i];
+        if (k > 1)
+        {
+            const uint64_t base_squared = mod_sqr<Kernel>(bases[i], n);
+            for (int j = 1; j < (1 << (k - 1)); j++)
+            {
+                powers[j] = mod_multiply<Kernel>(powers[j - 1], base_squared, n);
+            }
+        }
+
+        int b = bits - 1;
+        while (b >= 0)
+        {
+            if (((e >> b) & 0x1) == 0)
+            {
+                b--;
+                continue;
+            }
+            int j = b - k + 1 < 0 ? 0 : b - k + 1;
+            while (((e >> j) & 0x1) == 0)
+            {
+                j++;
+            }
+            windows[64 * i + j] = static_cast<uint8_t>((e >> j) & ((1UL << (b - j + 1)) - 1));
+            b = j - 1;
+        }
+    }
+
+    uint64_t y = 1;
+    bool first = true;
+    for (int b = max_bits - 1; b >= 0; b--)
+    {
+        if (!first)
+        {
+            y = mod_sqr<Kernel>(y, n);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint8_t window = windows[64 * i + b];
+            if (window)
+            {
+                y = first ? odd_powers[8 * i + (window >> 1)] : mod_multiply<Kernel>(y, odd_powers[8 * i + (window >> 1)], n);
+                first = false;
+            }
+        }
+    }
+    return y;
+}
+
+// This function computes (a[0] * b[0] + ... + a[len - 1] * b[len - 1]) % n, all a[i] and b[i] have to be smaller than n.
+// Instead of one mod_multiply and one mod_add per term, the 128 bit products are summed up without reduction
+// (lazy reduction), and the sum is only reduced when it could overflow. For n < 2^k, a product is smaller than
+// 2^(2k), so a reduced sum plus 2^(128 - 2k) products still fit into 128 bits:
+// - k <= 32: the products have 64 bits, any number of them fits, the sum is reduced once at the end.
+// - 32 < k < 60: the sum is reduced after every block of 2^(128 - 2k) >= 2^10 products.
+// - k >= 60: the blocks would be short, so the carries out of the 128 bit sum are counted instead, and
+//   sum + carries * 2^128 is reduced once at the end, with 2^128 % n = ((2^64 - n) % n)^2 % n.
+// See mod_dot_batch in modular_arithmetic_batch.h for the vectorized version.
+inline uint64_t mod_dot(const uint64_t *a, const uint64_t *b, size_t len, uint64_t n)
+{
+    assert(n > 0);
+
+    const int bits = 64 - __builtin_clzll(n);
+    if (bits < 60)
+    {
+        const size_t block = bits <= 32 ? len : static_cast<size_t>(1) << (128 - 2 * bits);
+        unsigned __int128 sum = 0;
+        for (size_t i = 0; i < len;)
+        {
+            const size_t end = len - i > block ? i + block : len;
+            for (; i < end; i++)
+            {
+                sum += static_cast<unsigned __int128>(a[i]) * b[i];
+            }
+            sum %= n;
+        }
+        return static_cast<uint64_t>(sum);
+    }
+
+    unsigned __int128 sum = 0;
+    uint64_t carries = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        const unsigned __int128 product = static_cast<unsigned __int128>(a[i]) * b[i];
+        sum += product;
+        carries += sum < product;
+    }
+    const uint64_t r = (0 - n) % n; // 2^64 % n
+    return mod_add(static_cast<uint64_t>(sum % n), mod_multiply(carries % n, mod_sqr(r, n), n), n);
+}
+
+// This function returns u3 and sets tu1, tu2 such that that gcd(a,n) == u3 == a*tu1 + n*tu2.
+// This can be used to determine the multiplicative inverse:
+// To invert a % n, we need gcd(a, n) = 1.
+// We can call the extended GCD algorithm with a and n as input and check if the GCD is 1.
+// If so, we also get tu1, tu2 such that a*tu1 + n*tu2 = u3 = 1. We then see that:
+// (a*tu1 + n*tu2) % n = a*tu1 % n = 1. Therefore, tu1 is the inverse of a.
+// Note that a and n need to be smaller than 2^63. For larger moduli, see mod_inverse.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
+inline uint64_t extended_greatest_common_divisor(int64_t a, int64_t n, int64_t &tu1, int64_t &tu2)
+{
+    int64_t u1 = 1, u2 = 0;
+    int64_t v1 = 0, v3 = n;
+    int64_t u3 = a, v2 = 1;
+    while (v3 != 0)
+    {
+        int64_t q = u3 / v3;
+        int64_t t1 = u1 - v1 * q;
+        u1 = v1;
+        v1 = t1;
+        int64_t t3 = u3 - v3 * q;
+        u3 = v3;
+        v3 = t3;
+        int64_t t2 = u2 - v2 * q;
+        u2 = v2;
+        v2 = t2;
+    }
+    tu1 = u1;
+    tu2 = u2;
+    return u3;
+}
+
+// Returns the multiplicative inverse of a modulo an odd n, see mod_inverse.
+// This is the binary extended GCD algorithm: it keeps x1 * a == u and x2 * a == v (mod n) and
+// reduces u and v by subtractions and shifts only, until u == v == gcd(a, n).
+// Since u and v are kept odd, u - v is even and all its trailing zeros are shifted out at once.
+// The cofactor is divided by 2^z in one step, as in Montgomery reduction: with m = -x * n^-1 % 2^z,
+// x + m * n is divisible by 2^z and (x + m * n) / 2^z < n, since x < n and m < 2^z.
+// The loop body selects with conditional moves instead of branching, since the comparison u < v is unpredictable.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), algorithm 14.61.
+inline std::optional<uint64_t> mod_inverse_odd(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n & 0x1);
+
+    if (n == 1)
+    {
+        return 0;
+    }
+    if (a == 0)
+    {
+        return std::nullopt;
+    }
+
+    // Newton iteration for n^-1 % 2^64, every step doubles the number of correct bits (n * n == 1 (mod 8)).
+    uint64_t n_inv = n;
+    for (int i = 0; i < 5; i++)
+    {
+        n_inv *= 2 - n * n_inv;
+    }
+    const uint64_t n_neg_inv = 0 - n_inv;
+    const auto divide_by_power_of_two = [n, n_neg_inv](uint64_t x, int zeros) {
+        const uint64_t m = (x * n_neg_inv) & ((1UL << zeros) - 1);
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(m) * n + x) >> zeros);
+    };
+
+    int zeros = __builtin_ctzll(a);
+    uint64_t u = a >> zeros;
+    uint64_t v = n;
+    uint64_t x1 = divide_by_power_of_two(1, zeros);
+    uint64_t x2 = 0;
+    while (u != v)
+    {
+        // Both u and v are odd. The smaller one becomes v, the even difference is shifted into u.
+        const bool less = u < v;
+        const uint64_t difference = less ? v - u : u - v;
+        const uint64_t x_difference = less ? mod_subtract(x2, x1, n) : mod_subtract(x1, x2, n);
+        v = less ? u : v;
+        x2 = less ? x1 : x2;
+        zeros = __builtin_ctzll(difference);
+        u = difference >> zeros;
+        x1 = divide_by_power_of_two(x_difference, zeros);
+    }
+    if (u != 1)
+    {
+        return std::nullopt;
+    }
+    return x1;
+}
+
+// Returns the multiplicative inverse of a, such that mod_multiply(a, mod_inverse(a, n).value(), n) == 1,
+// or std::nullopt if gcd(a, n) != 1. Contrarily to mod_multiplicative_inverse, n does not need to be a prime,
+// and contrarily to extended_greatest_common_divisor, the full range of n is supported.
+// For odd n, the binary extended GCD algorithm is used (see mod_inverse_odd), which requires no division.
+// For even n, a has to be odd and its inverse follows from x = n^-1 % a, which is computed with the odd modulus a:
+// a * (n * (a - x) + 1) / a = n * (a - x) + 1 == 1 (mod n), where n * (a - x) + 1 is divisible by a.
+inline std::optional<uint64_t> mod_inverse(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    if (n & 0x1)
+    {
+        return mod_inverse_odd(a, n);
+    }
+    if ((a & 0x1) == 0)
+    {
+        return std::nullopt;
+    }
+    if (a == 1)
+    {
+        return 1;
+    }
+    const std::optional<uint64_t> x = mod_inverse_odd(n % a, a);
+    if (!x)
+    {
+        return std::nullopt;
+    }
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(n) * (a - *x) + 1) / a);
+}
+
+// Returns the same as mod_inverse, but uses Lehmer's variant of the extended Euclidean algorithm
+// (https://en.wikipedia.org/wiki/Lehmer%27s_GCD_algorithm).
+// As long as the operands are large, the quotients of several Euclidean steps are determined from their leading
+// 32 bits, and combined into one matrix (A B; C D), which is then applied to the full operands and cofactors at once.
+// It keeps xu * a == u and xv * a == v (mod n), with u = n and v = a at the start.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), algorithm 14.57.
+inline std::optional<uint64_t> mod_inverse_lehmer(uint64_t a, uint64_t n)
+{
+    assert(a < n);
+    assert(n > 0);
+
+    // Computes (x * y + z * w) % n for signed single precision factors x, z.
+    const auto combine = [n](int64_t x, uint64_t y, int64_t z, uint64_t w)
+    {
+        const __int128 value = static_cast<__int128>(x) * y + static_cast<__int128>(z) * w;
+        const __int128 remainder = value % static_cast<__int128>(n);
+        return static_cast<uint64_t>(remainder < 0 ? remainder + n : remainder);
+    };
+
+    uint64_t u = n;
+    uint64_t v = a;
+    uint64_t xu = 0;
+    uint64_t xv = 1 % n;
+    while (v >> 32)
+    {
+        const int shift = 32 - __builtin_clzll(u);
+        int64_t u_high = static_cast<int64_t>(u >> shift);
+        int64_t v_high = static_cast<int64_t>(v >> shift);
+        int64_t A = 1, B = 0, C = 0, D = 1;
+        // The quotient is only taken if it is the same for both bounds of the leading digits.
+        while (v_high + C != 0 && v_high + D != 0)
+        {
+            const int64_t q = (u_high + A) / (v_high + C);
+            if (q != (u_high + B) / (v_high + D))
+            {
+                break;
+            }
+            int64_t t = A - q * C;
+            A = C;
+            C = t;
+            t = B - q * D;
+            B = D;
+            D = t;
+            t = u_high - q * v_high;
+            u_high = v_high;
+            v_high = t;
+        }
+
+        if (B == 0)
+        {
+            // No quotient could be determined from the leading digits, so one full Euclidean step is done.
+            const uint64_t q = u / v;
+            const uint64_t t = u - q * v;
+            u = v;
+            v = t;
+            const uint64_t x = mod_subtract(xu, mod_multiply(q % n, xv, n), n);
+            xu = xv;
+            xv = x;
+        }
+        else
+        {
+            const uint64_t new_u = static_cast<uint64_t>(static_cast<__int128>(A) * u + static_cast<__int128>(B) * v);
+            const uint64_t new_v = static_cast<uint64_t>(static_cast<__int128>(C) * u + static_cast<__int128>(D) * v);
+            u = new_u;
+            v = new_v;
+            const uint64_t new_xu = combine(A, xu, B, xv);
+            const uint64_t new_xv = combine(C, xu, D, xv);
+            xu = new_xu;
+            xv = new_xv;
+        }
+    }
+
+    // The remaining steps only need single precision.
+    while (v != 0)
+    {
+        const uint64_t q = u / v;
+        const uint64_t t = u - q * v;
+        u = v;
+        v = t;
+        const uint64_t x = mod_subtract(xu, mod_multiply(q % n, xv, n), n);
+        xu = xv;
+        xv = x;
+    }
+    if (u != 1)
+    {
+        return std::nullopt;
+    }
+    return xu;
+}
+
+// Inverts in[begin], ..., in[end - 1] for mod_inverse_batch and returns the number of non-invertible elements.
+template <class Kernel>
+size_t mod_inverse_batch_range(const uint64_t *in, uint64_t *out, size_t begin, size_t end, uint64_t n)
+{
+    // out[i] = in[begin] * ... * in[i], skipping zeros.
+    uint64_t product = 1;
+    size_t zeros = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        assert(in[i] < n);
+        if (in[i] == 0)
+        {
+            zeros++;
+        }
+        else
+        {
+            product = mod_multiply<Kernel>(product, in[i], n);
+        }
+        out[i] = product;
+    }
+
+    const std::optional<uint64_t> product_inverse = mod_inverse(product, n);
+    if (!product_inverse)
+    {
+        // At least one element shares a factor with n, so each element is inverted separately.
+        size_t non_invertible = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            const std::optional<uint64_t> inverse = mod_inverse(in[i], n);
+            out[i] = inverse.value_or(0);
+            non_invertible += !inverse;
+        }
+        return non_invertible;
+    }
+
+    // inverse = (in[begin] * ... * in[i])^-1, so in[i]^-1 = inverse * out[i - 1].
+    uint64_t inverse = *product_inverse;
+    for (size_t i = end; i-- > begin;)
+    {
+        if (in[i] == 0)
+        {
+            out[i] = 0;
+            continue;
+        }
+        const uint64_t element = in[i];
+        out[i] = i > begin ? mod_multiply<Kernel>(inverse, out[i - 1], n) : inverse;
+        inverse = mod_multiply<Kernel>(inverse, element, n);
+    }
+    return zeros;
+}
+
+// This function computes out[i] = in[i]^-1 % n for all i < len, using Montgomery's trick:
+// With the prefix products p_i = in[0] * ... * in[i], only p_(len - 1) needs to be inverted, since
+// in[i]^-1 = p_(len - 1)^-1 * in[len - 1] * ... * in[i + 1] * p_(i - 1).
+// This requires one inversion with mod_inverse and 3 * (len - 1) multiplications.
+// Elements which are not invertible (0, or not coprime to n) result in 0, the function returns their number.
+// The array can be split into chunks which are processed in parallel, every chunk needs its own inversion.
+// The output must not alias the input.
+// From: Peter L. Montgomery, Speeding the Pollard and elliptic curve methods of factorization (https://doi.org/10.2307/2007888).
+template <class Kernel = DefaultMultiplyKernel>
+size_t mod_inverse_batch(const uint64_t *in, uint64_t *out, size_t len, uint64_t n, size_t threads = 1)
+{
+    assert(n > 1);
+    assert(len == 0 || in != out);
+    assert(threads > 0);
+
+    const size_t chunk = (len + threads - 1) / threads;
+    if (threads == 1 || chunk == 0)
+    {
+        return mod_inverse_batch_range<Kernel>(in, out, 0, len, n);
+    }
+
+    std::vector<size_t> non_invertible(threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++)
+    {
+        const size_t begin = t * chunk < len ? t * chunk : len;
+        const size_t end = begin + chunk < len ? begin + chunk : len;
+        workers.emplace_back([=, &non_invertible]()
+                             { non_invertible[t] = mod_inverse_batch_range<Kernel>(in, out, begin, end, n); });
+    }
+    size_t total = 0;
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers[t].join();
+        total += non_invertible[t];
+    }
+    return total;
+}
+
+// Montgomery multiplication (https://en.wikipedia.org/wiki/Montgomery_modular_multiplication).
+// mod_multiply needs up to 128 calls of mod_add per product. Montgomery multiplication instead works on
+// numbers in "Montgomery form" a' = a * R % n with R = 2^64, where a product only needs 64x64->128 bit
+// multiplications and no division: a' * b' * R^-1 = (a * b)' (mod n).
+// The constants R % n, R^2 % n and n^-1 % R are computed once per modulus, so a context pays off when
+// many multiplications or exponentiations are done with the same modulus.
+// Montgomery multiplication requires gcd(R, n) == 1, i.e. an odd modulus n.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.6.
+class MontgomeryContext
+{
+public:
+    explicit constexpr MontgomeryContext(uint64_t n)
+        : n(n)
+    {
+        assert(n & 0x1);
+
+        // Newton iteration for n^-1 % 2^64: n * n == 1 (mod 8), so n is its own inverse for the lowest 3 bits.
+        // Every step doubles the number of correct bits: 3 -> 6 -> 12 -> 24 -> 48 -> 96.
+        uint64_t inverse = n;
+        for (int i = 0; i < 5; i++)
+        {
+            inverse *= 2 - n * inverse;
+        }
+        assert(inverse * n == 1);
+        n_inv = inverse;
+
+        // R % n == (R - n) % n, which fits into 64 bits.
+        r = (0 - n) % n;
+        r2 = static_cast<uint64_t>(static_cast<unsigned __int128>(r) * r % n);
+    }
+
+    constexpr uint64_t modulus() const
+    {
+        return n;
+    }
+
+    // Returns the Montgomery form of 1, i.e. R % n.
+    constexpr uint64_t one() const
+    {
+        return r;
+    }
+
+    // Converts a into Montgomery form: a * R % n.
+    constexpr uint64_t to_montgomery(uint64_t a) const
+    {
+        assert(a < n);
+        return multiply(a, r2);
+    }
+
+    // Converts a from Montgomery form back into Z_n: a * R^-1 % n.
+    constexpr uint64_t from_montgomery(uint64_t a) const
+    {
+        assert(a < n);
+        return reduce(a);
+    }
+
+    // This function computes (a * b * R^-1) % n, i.e. the product of two numbers in Montgomery form.
+    constexpr uint64_t multiply(uint64_t a, uint64_t b) const
+    {
+        assert(a < n);
+        assert(b < n);
+        return reduce(static_cast<unsigned __int128>(a) * b);
+    }
+
+    // This function computes (a * a * R^-1) % n.
+    constexpr uint64_t square(uint64_t a) const
+    {
+        return multiply(a, a);
+    }
+
+    // This function computes a^e in Montgomery form, where a is in Montgomery form.
+    // It is the same algorithm as mod_power, but with Montgomery multiplications.
+    constexpr uint64_t power(uint64_t a, uint64_t e) const
+    {
+        assert(a < n);
+
+        uint64_t z = a;
+        uint64_t y = r;
+        while (e)
+        {
+            if (e & 0x1)
+            {
+                y = multiply(y, z);
+            }
+            e >>= 1;
+            if (0 == e)
+            {
+                break;
+            }
+            z = square(z);
+        }
+        return y;
+    }
+
+private:
+    // Montgomery reduction (REDC) computes t * R^-1 % n for t < n * R.
+    // With m = t * n^-1 % R, the lower halves of t and m * n are equal, so t - m * n is divisible by R.
+    // The quotient (t - m * n) / R is the difference of the upper halves, which lies in (-n, n).
+    // Subtracting m * n instead of adding -m * n avoids the overflow of t + m * n for n >= 2^63.
+    constexpr uint64_t reduce(unsigned __int128 t) const
+    {
+        const uint64_t m = static_cast<uint64_t>(t) * n_inv;
+        const uint64_t mn_high = static_cast<uint64_t>((static_cast<unsigned __int128>(m) * n) >> 64);
+        const uint64_t t_high = static_cast<uint64_t>(t >> 64);
+        const uint64_t difference = t_high - mn_high;
+        return t_high < mn_high ? difference + n : difference;
+    }
+
+    uint64_t n = 0;
+    uint64_t n_inv = 0; // n^-1 % R
+    uint64_t r = 0;     // R % n
+    uint64_t r2 = 0;    // R^2 % n
+};
+
+// Barrett reduction (https://en.wikipedia.org/wiki/Barrett_reduction).
+// Contrarily to Montgomery multiplication, Barrett reduction works for any modulus n > 0, including even ones,
+// and the numbers stay in Z_n. The division x / n is replaced by a multiplication with the precomputed
+// m = floor(2^128 / n) and a shift: q = floor(x * m / 2^128) underestimates floor(x / n) by at most 2,
+// which is fixed by conditional subtractions. Therefore, there is no division instruction in the hot path.
+class BarrettReducer
+{
+public:
+    explicit constexpr BarrettReducer(uint64_t n)
+        : n(n)
+    {
+        assert(n > 0);
+        // floor((2^128 - 1) / n) is equal to floor(2^128 / n), unless n is a power of two.
+        // In that case it is one less, which is covered by the final subtractions in reduce.
+        m = ~static_cast<unsigned __int128>(0) / n;
+    }
+
+    constexpr uint64_t modulus() const
+    {
+        return n;
+    }
+
+    // This function computes x % n.
+    constexpr uint64_t reduce(unsigned __int128 x) const
+    {
+        const uint64_t x0 = static_cast<uint64_t>(x);
+        const uint64_t x1 = static_cast<uint64_t>(x >> 64);
+        const uint64_t m0 = static_cast<uint64_t>(m);
+        const uint64_t m1 = static_cast<uint64_t>(m >> 64);
+
+        // q = floor(x * m / 2^128), computed from the four 64x64->128 bit partial products.
+        const unsigned __int128 x0m0 = static_cast<unsigned __int128>(x0) * m0;
+        const unsigned __int128 x0m1 = static_cast<unsigned __int128>(x0) * m1;
+        const unsigned __int128 x1m0 = static_cast<unsigned __int128>(x1) * m0;
+        const unsigned __int128 x1m1 = static_cast<unsigned __int128>(x1) * m1;
+        const unsigned __int128 middle = (x0m0 >> 64) + static_cast<uint64_t>(x0m1) + static_cast<uint64_t>(x1m0);
+        const unsigned __int128 q = x1m1 + (x0m1 >> 64) + (x1m0 >> 64) + (middle >> 64);
+
+        // The remainder is smaller than 3 * n, so it fits into 128 bits even if q * n does not.
+        unsigned __int128 remainder = x - q * n;
+        while (remainder >= n)
+        {
+            remainder -= n;
+        }
+        return static_cast<uint64_t>(remainder);
+    }
+
+    // This function computes (a * b) % n.
+    constexpr uint64_t multiply(uint64_t a, uint64_t b) const
+    {
+        assert(a < n);
+        assert(b < n);
+        return reduce(static_cast<unsigned __int128>(a) * b);
+    }
+
+    // This function computes (a * a) % n.
+    constexpr uint64_t square(uint64_t a) const
+    {
+        return multiply(a, a);
+    }
+
+    // This function computes (a^e) % n.
+    // It is the same algorithm as mod_power, but with Barrett multiplications.
+    constexpr uint64_t power(uint64_t a, uint64_t e) const
+    {
+        assert(a < n);
+
+        uint64_t z = a;
+        uint64_t y = reduce(1);
+        while (e)
+        {
+            if (e & 0x1)
+            {
+                y = multiply(y, z);
+            }
+            e >>= 1;
+            if (0 == e)
+            {
+                break;
+            }
+            z = square(z);
+        }
+        return y;
+    }
+
+private:
+    uint64_t n = 0;
+    unsigned __int128 m = 0; // floor(2^128 / n)
+};
+
+// Shoup's modular multiplication with a precomputed constant
+// (David Harvey, Faster arithmetic for number-theoretic transforms, https://doi.org/10.1016/j.jsc.2013.09.002).
+// If one factor w is reused for many products, the quotient w' = floor(w * 2^64 / n) is computed once.
+// Then q = floor(a * w' / 2^64) is the quotient floor(a * w / n) or one less, so the remainder
+// a * w - q * n is in [0, 2n) and one conditional subtraction is left. Since the remainder is known to be smaller
+// than 2n < 2^64, it is computed with the lower 64 bits of both products only.
+// So a product needs one high and two low multiplications and no division, nor a conversion as for Montgomery
+// multiplication. This requires n < 2^63.
+class ShoupMultiplier
+{
+public:
+    constexpr ShoupMultiplier(uint64_t w, uint64_t n)
+        : w(w), n(n)
+    {
+        assert(n > 0 && n < (1UL << 63));
+        assert(w < n);
+        w_quotient = static_cast<uint64_t>((static_cast<unsigned __int128>(w) << 64) / n);
+    }
+
+    constexpr uint64_t multiplier() const
+    {
+        return w;
+    }
+
+    // Returns floor(w * 2^64 / n).
+    constexpr uint64_t quotient() const
+    {
+        return w_quotient;
+    }
+
+    constexpr uint64_t modulus() const
+    {
+        return n;
+    }
+
+    // This function computes (a * w) % n, a can be any 64 bit number.
+    constexpr uint64_t multiply(uint64_t a) const
+    {
+        const uint64_t r = multiply_lazy(a);
+        return r >= n ? r - n : r;
+    }
+
+    // This function computes (a * w) % n or (a * w) % n + n, i.e. a number in [0, 2n) which is congruent to a * w.
+    constexpr uint64_t multiply_lazy(uint64_t a) const
+    {
+        const uint64_t q = static_cast<uint64_t>((static_cast<unsigned __int128>(a) * w_quotient) >> 64);
+        return a * w - q * n;
+    }
+
+private:
+    uint64_t w = 0;
+    uint64_t n = 0;
+    uint64_t w_quotient = 0; // floor(w * 2^64 / n)
+};
+
+// Moduli of special form (Richard Crandall and Carl Pomerance, Prime Numbers: A Computational Perspective,
+// chapter 9.2.3) are reduced with shifts, additions and multiplications by small constants instead of a division.
+// The form of the modulus is selected through a modulus policy type, which provides:
+// static constexpr uint64_t modulus,
+// static uint64_t reduce(unsigned __int128 x), which computes x % modulus for any 128 bit x,
+// static uint64_t multiply(uint64_t a, uint64_t b), which computes (a * b) % modulus for a, b < modulus.
+// The policies are used through mod_reduce<Modulus>, mod_multiply<Modulus> and mod_power<Modulus>.
+//
+// Example:
+// using Mersenne61 = MersenneModulus<61>;
+// const uint64_t y = mod_power<Mersenne61>(3, 1000); // 3^1000 % (2^61 - 1)
+
+// A Mersenne modulus n = 2^K - 1. Since 2^K == 1 (mod n), x = high * 2^K + low == high + low (mod n), so the
+// reduction is (x & n) + (x >> K) repeated until the value is smaller than 2^K.
+// A product of a, b < n needs one step and one conditional subtraction.
+template <int K>
+struct MersenneModulus
+{
+    static_assert(K >= 2 && K <= 63, "The modulus must be 2^K - 1 with 2 <= K <= 63.");
+    static constexpr uint64_t modulus = (1UL << K) - 1;
+
+    static constexpr uint64_t reduce(unsigned __int128 x)
+    {
+        if constexpr (K >= 33 && K <= 61)
+        {
+            // x = high * 2^64 + low and 2^64 == 2^(64 - K) (mod n), so high * 2^(64 - K) is split at bit K as well.
+            // All four parts are smaller than 2^62, so their sum fits into 64 bits.
+            const uint64_t low = static_cast<uint64_t>(x);
+            const uint64_t high = static_cast<uint64_t>(x >> 64);
+            const uint64_t sum = (low & modulus) + (low >> K) + ((high << (64 - K)) & modulus) + (high >> (2 * K - 64));
+            const uint64_t y = (sum & modulus) + (sum >> K);
+            return y >= modulus ? y - modulus : y;
+        }
+        while (x >> 64)
+        {
+            x = (x & modulus) + (x >> K);
+        }
+        uint64_t y = static_cast<uint64_t>(x);
+        while (y > modulus)
+        {
+            y = (y & modulus) + (y >> K);
+        }
+        return y == modulus ? 0 : y;
+    }
+
+    // a * b < 2^2K, so both halves fit into 64 bits and their sum is smaller than 2n.
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        const unsigned __int128 x = static_cast<unsigned __int128>(a) * b;
+        const uint64_t y = (static_cast<uint64_t>(x) & modulus) + static_cast<uint64_t>(x >> K);
+        return y >= modulus ? y - modulus : y;
+    }
+};
+
+// A pseudo-Mersenne modulus n = 2^64 - C with C < 2^32. Since 2^64 == C (mod n), x = high * 2^64 + low is folded
+// into high * C + low < (C + 1) * 2^64. Its upper half is at most C, so the second fold high' * C + low' fits into
+// 64 bits plus a carry, and the carry 2^64 == C is added back. The result is smaller than 2^64 < 2n, so one
+// conditional subtraction is left. The carries are added with masks, since branches on them are not predictable.
+template <uint64_t C>
+struct PseudoMersenneModulus
+{
+    static_assert(C > 0 && C < (1UL << 32), "The modulus must be 2^64 - C with 0 < C < 2^32.");
+    static constexpr uint64_t modulus = 0 - C;
+
+    static constexpr uint64_t reduce(unsigned __int128 x)
+    {
+        const unsigned __int128 t = static_cast<unsigned __int128>(static_cast<uint64_t>(x >> 64)) * C + static_cast<uint64_t>(x);
+        const uint64_t t_low = static_cast<uint64_t>(t);
+        uint64_t y = t_low + static_cast<uint64_t>(t >> 64) * C;
+        y += C & (0 - static_cast<uint64_t>(y < t_low));
+        return y >= modulus ? y - modulus : y;
+    }
+
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        return reduce(static_cast<unsigned __int128>(a) * b);
+    }
+};
+
+// A Solinas modulus n = 2^64 - 2^L + 1 (Jerome A. Solinas, Generalized Mersenne Numbers,
+// https://cacr.uwaterloo.ca/techreports/1999/corr99-39.pdf).
+// Since 2^64 == 2^L - 1 (mod n), it is a pseudo-Mersenne modulus with C = 2^L - 1, and the multiplication by C is a
+// shift and a subtraction.
+// For L = 32, i.e. n = 2^64 - 2^32 + 1, also 2^96 == -1 (mod n), so x = low + a * 2^64 + b * 2^96 with 32 bit a and b
+// is reduced to low - b + a * (2^32 - 1), which needs a single 32x32 bit multiplication.
+template <int L>
+struct SolinasModulus
+{
+    static_assert(L > 0 && L <= 32, "The modulus must be 2^64 - 2^L + 1 with 0 < L <= 32.");
+    static constexpr uint64_t modulus = (0 - (1UL << L)) + 1;
+
+    static constexpr uint64_t reduce(unsigned __int128 x)
+    {
+        if constexpr (L == 32)
+        {
+            constexpr uint64_t epsilon = 0xffffffffUL; // 2^64 % n
+            const uint64_t low = static_cast<uint64_t>(x);
+            const uint64_t a = static_cast<uint64_t>(x >> 64) & epsilon;
+            const uint64_t b = static_cast<uint64_t>(x >> 96);
+            // A borrow of 2^64 is a subtraction of 2^64 % n, a carry of 2^64 is an addition of it.
+            uint64_t t = low - b;
+            t -= epsilon & (0 - static_cast<uint64_t>(low < b));
+            uint64_t y = t + a * epsilon;
+            y += epsilon & (0 - static_cast<uint64_t>(y < t));
+            return y >= modulus ? y - modulus : y;
+        }
+        else
+        {
+            return PseudoMersenneModulus<(1UL << L) - 1>::reduce(x);
+        }
+    }
+
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        return reduce(static_cast<unsigned __int128>(a) * b);
+    }
+};
+
+// This function computes x % Modulus::modulus for any 128 bit x.
+template <class Modulus>
+constexpr inline uint64_t mod_reduce(unsigned __int128 x)
+{
+    return Modulus::reduce(x);
+}
+
+// This function computes (a * b) % Modulus::modulus.
+template <class Modulus>
+constexpr inline uint64_t mod_multiply(uint64_t a, uint64_t b)
+{
+    assert(a < Modulus::modulus);
+    assert(b < Modulus::modulus);
+    return Modulus::multiply(a, b);
+}
+
+// This function computes (a^e) % Modulus::modulus.
+// It is the same algorithm as mod_power, but with the reduction of the modulus policy.
+template <class Modulus>
+constexpr inline uint64_t mod_power(uint64_t a, uint64_t e)
+{
+    assert(a < Modulus::modulus);
+
+    uint64_t z = a;
+    uint64_t y = 1;
+    while (e)
+    {
+        if (e & 0x1)
+        {
+            y = Modulus::multiply(y, z);
+        }
+        e >>= 1;
+        if (0 == e)
+        {
+            break;
+        }
+        z = Modulus::multiply(z, z);
+    }
+    return y;
+}
+
+// ModInt<N> is an element of Z_N, where the modulus N is known at compile time.
+// Contrarily to the functions above, the modulus does not need to be passed (and checked) on every call, and the
+// reduction constants are computed by the compiler: Montgomery multiplication is used for odd N, Barrett reduction
+// for even N and the MersenneModulus policy for N = 2^K - 1. All operations are constexpr, so ModInt values (and
+// tables of them) can be computed at compile time.
+//
+// Example:
+// constexpr ModInt<9223372036854775337UL> a = 97845874148483UL;
+// static_assert((a * a.inverse()).value() == 1);
+
+// The representation of the values of a ModInt: Montgomery form for odd N.
+template <uint64_t N, bool IsOdd = (N & 0x1) != 0>
+struct ModIntReduction
+{
+    static constexpr MontgomeryContext context{N};
+
+    static constexpr uint64_t to_representation(uint64_t a)
+    {
+        return context.to_montgomery(a);
+    }
+
+    static constexpr uint64_t from_representation(uint64_t a)
+    {
+        return context.from_montgomery(a);
+    }
+
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        return context.multiply(a, b);
+    }
+
+    static constexpr uint64_t power(uint64_t a, uint64_t e)
+    {
+        return context.power(a, e);
+    }
+};
+
+// The representation of the values of a ModInt: the value itself for even N.
+template <uint64_t N>
+struct ModIntReduction<N, false>
+{
+    static constexpr BarrettReducer context{N};
+
+    static constexpr uint64_t to_representation(uint64_t a)
+    {
+        return a;
+    }
+
+    static constexpr uint64_t from_representation(uint64_t a)
+    {
+        return a;
+    }
+
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        return context.multiply(a, b);
+    }
+
+    static constexpr uint64_t power(uint64_t a, uint64_t e)
+    {
+        return context.power(a, e);
+    }
+};
+
+// The representation of the values of a ModInt: the value itself for a special-form modulus, which is reduced by
+// the modulus policy.
+template <class Modulus>
+struct ModIntSpecialReduction
+{
+    static constexpr uint64_t to_representation(uint64_t a)
+    {
+        return a;
+    }
+
+    static constexpr uint64_t from_representation(uint64_t a)
+    {
+        return a;
+    }
+
+    static constexpr uint64_t multiply(uint64_t a, uint64_t b)
+    {
+        return Modulus::multiply(a, b);
+    }
+
+    static constexpr uint64_t power(uint64_t a, uint64_t e)
+    {
+        return mod_power<Modulus>(a, e);
+    }
+};
+
+// Returns K if n = 2^K - 1 with 2 <= K <= 63, otherwise 0.
+constexpr inline int mersenne_exponent(uint64_t n)
+{
+    return n > 2 && n < (1UL << 63) && (n & (n + 1)) == 0 ? __builtin_popcountll(n) : 0;
+}
+
+// Mersenne moduli are reduced with their policy, which is faster than a Montgomery multiplication.
+// The other special forms are not, their advantage is the reduction of 128 bit values without conversion.
+template <uint64_t N>
+using ModIntReductionFor = std::conditional_t<mersenne_exponent(N) != 0,
+                                              ModIntSpecialReduction<MersenneModulus<mersenne_exponent(N) != 0 ? mersenne_exponent(N) : 2>>,
+                                              ModIntReduction<N>>;
+
+template <uint64_t N>
+class ModInt
+{
+    static_assert(N > 0, "The modulus must be positive.");
+    using Reduction = ModIntReductionFor<N>;
+
+public:
+    constexpr ModInt() = default;
+
+    // Converts any (even a non-reduced) value into Z_N.
+    constexpr ModInt(uint64_t a)
+        : representation(Reduction::to_representation(mod_pos(a, N)))
+    {
+    }
+
+    static constexpr uint64_t modulus()
+    {
+        return N;
+    }
+
+    // Returns the value as an element of Z_N.
+    constexpr uint64_t value() const
+    {
+        return Reduction::from_representation(representation);
+    }
+
+    // Addition and subtraction are the same in Montgomery form, since a * R + b * R = (a + b) * R.
+    constexpr ModInt &operator+=(const ModInt &other)
+    {
+        representation = mod_add(representation, other.representation, N);
+        return *this;
+    }
+
+    constexpr ModInt &operator-=(const ModInt &other)
+    {
+        representation = mod_subtract(representation, other.representation, N);
+        return *this;
+    }
+
+    constexpr ModInt &operator*=(const ModInt &other)
+    {
+        representation = Reduction::multiply(representation, other.representation);
+        return *this;
+    }
+
+    // Note that the division only works when N is a prime, see mod_multiplicative_inverse.
+    constexpr ModInt &operator/=(const ModInt &other)
+    {
+        return *this *= other.inverse();
+    }
+
+    constexpr ModInt operator-() const
+    {
+        return from_representation(mod_additive_inverse(representation, N));
+    }
+
+    friend constexpr ModInt operator+(ModInt a, const ModInt &b)
+    {
+        return a += b;
+    }
+
+    friend constexpr ModInt operator-(ModInt a, const ModInt &b)
+    {
+        return a -= b;
+    }
+
+    friend constexpr ModInt operator*(ModInt a, const ModInt &b)
+    {
+        return a *= b;
+    }
+
+    friend constexpr ModInt operator/(ModInt a, const ModInt &b)
+    {
+        return a /= b;
+    }
+
+    // The representation is unique, so it can be compared directly.
+    friend constexpr bool operator==(const ModInt &a, const ModInt &b)
+    {
+        return a.representation == b.representation;
+    }
+
+    friend constexpr bool operator!=(const ModInt &a, const ModInt &b)
+    {
+        return a.representation != b.representation;
+    }
+
+    // This function computes this^e.
+    constexpr ModInt pow(uint64_t e) const
+    {
+        return from_representation(Reduction::power(representation, e));
+    }
+
+    // Returns the multiplicative inverse, such that this * inverse() == 1.
+    // Same as mod_multiplicative_inverse, the multiplicative inverse only exists when N is a prime.
+    constexpr ModInt inverse() const
+    {
+        return pow(N - 2);
+    }
+
+private:
+    static constexpr ModInt from_representation(uint64_t representation)
+    {
+        ModInt result;
+        result.representation = representation;
+        return result;
+    }
+
+    uint64_t representation = 0;
+};
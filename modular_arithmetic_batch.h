@@ -0,0 +1,793 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define MODULAR_ARITHMETIC_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+// This code applies the modular arithmetic functions element-wise to arrays which share one modulus n.
+// The scalar functions in modular_arithmetic.h branch on their inputs, which is slow for random data.
+// The batch functions use a compare and select instead, which maps to SIMD instructions:
+// e.g. (a - b) % n = a - b + (a < b ? n : 0), where a - b is allowed to wrap around.
+// The instruction set is detected at runtime, the AVX2 and AVX-512 paths process 4 and 8 elements at once.
+// The multiplications use Montgomery multiplication in the lanes, see mod_multiply_batch.
+// All paths give bit-identical results to the scalar functions, given that the inputs are elements of Z_n.
+// The output may alias the inputs.
+
+enum class BatchIsa
+{
+    Scalar,
+    Avx2,
+    Avx512,
+    Avx512Ifma
+};
+
+// Returns the best instruction set for the batch functions that is supported by the CPU.
+inline BatchIsa detect_batch_isa()
+{
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    static const BatchIsa isa = []
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma"))
+        {
+            return BatchIsa::Avx512Ifma;
+        }
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            return BatchIsa::Avx512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return BatchIsa::Avx2;
+        }
+        return BatchIsa::Scalar;
+    }();
+    return isa;
+#else
+    return BatchIsa::Scalar;
+#endif
+}
+
+// Each operation provides the branchless scalar function and the corresponding AVX2 and AVX-512 functions.
+// AVX2 has no unsigned 64 bit comparison, so both sides are shifted by 2^63 and compared as signed integers.
+
+// (a + b) % n = a - (n - b) + (a < n - b ? n : 0).
+struct BatchAddOperation
+{
+    static uint64_t scalar(uint64_t a, uint64_t b, uint64_t n)
+    {
+        const uint64_t d = n - b;
+        return a - d + (a < d ? n : 0);
+    }
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, __m256i n)
+    {
+        const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+        const __m256i d = _mm256_sub_epi64(n, b);
+        const __m256i less = _mm256_cmpgt_epi64(_mm256_xor_si256(d, sign), _mm256_xor_si256(a, sign));
+        return _mm256_add_epi64(_mm256_sub_epi64(a, d), _mm256_and_si256(less, n));
+    }
+
+    __attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i b, __m512i n)
+    {
+        const __m512i d = _mm512_sub_epi64(n, b);
+        const __m512i difference = _mm512_sub_epi64(a, d);
+        return _mm512_mask_add_epi64(difference, _mm512_cmplt_epu64_mask(a, d), difference, n);
+    }
+#endif
+};
+
+// (a - b) % n = a - b + (a < b ? n : 0).
+struct BatchSubtractOperation
+{
+    static uint64_t scalar(uint64_t a, uint64_t b, uint64_t n)
+    {
+        return a - b + (a < b ? n : 0);
+    }
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, __m256i n)
+    {
+        const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+        const __m256i less = _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+        return _mm256_add_epi64(_mm256_sub_epi64(a, b), _mm256_and_si256(less, n));
+    }
+
+    __attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i b, __m512i n)
+    {
+        const __m512i difference = _mm512_sub_epi64(a, b);
+        return _mm512_mask_add_epi64(difference, _mm512_cmplt_epu64_mask(a, b), difference, n);
+    }
+#endif
+};
+
+// -a % n = (a == 0 ? 0 : n - a).
+struct BatchAdditiveInverseOperation
+{
+    static uint64_t scalar(uint64_t a, uint64_t n)
+    {
+        return a == 0 ? 0 : n - a;
+    }
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i n)
+    {
+        const __m256i zero = _mm256_cmpeq_epi64(a, _mm256_setzero_si256());
+        return _mm256_andnot_si256(zero, _mm256_sub_epi64(n, a));
+    }
+
+    __attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i n)
+    {
+        return _mm512_maskz_sub_epi64(_mm512_test_epi64_mask(a, a), n, a);
+    }
+#endif
+};
+
+// (a + 1) % n = (a + 1 == n ? 0 : a + 1).
+struct BatchIncrementOperation
+{
+    static uint64_t scalar(uint64_t a, uint64_t n)
+    {
+        const uint64_t successor = a + 1;
+        return successor == n ? 0 : successor;
+    }
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i n)
+    {
+        const __m256i successor = _mm256_add_epi64(a, _mm256_set1_epi64x(1));
+        return _mm256_andnot_si256(_mm256_cmpeq_epi64(successor, n), successor);
+    }
+
+    __attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i n)
+    {
+        const __m512i successor = _mm512_add_epi64(a, _mm512_set1_epi64(1));
+        return _mm512_maskz_mov_epi64(_mm512_cmpneq_epu64_mask(successor, n), successor);
+    }
+#endif
+};
+
+// (a - 1) % n = a - 1 + (a == 0 ? n : 0).
+struct BatchDecrementOperation
+{
+    static uint64_t scalar(uint64_t a, uint64_t n)
+    {
+        return a - 1 + (a == 0 ? n : 0);
+    }
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i n)
+    {
+        const __m256i zero = _mm256_cmpeq_epi64(a, _mm256_setzero_si256());
+        return _mm256_add_epi64(_mm256_sub_epi64(a, _mm256_set1_epi64x(1)), _mm256_and_si256(zero, n));
+    }
+
+    __attribute__((target("avx512f"))) static __m512i avx512(__m512i a, __m512i n)
+    {
+        const __m512i predecessor = _mm512_sub_epi64(a, _mm512_set1_epi64(1));
+        return _mm512_mask_add_epi64(predecessor, _mm512_testn_epi64_mask(a, a), predecessor, n);
+    }
+#endif
+};
+
+// Applies an operation element-wise, using the scalar, AVX2 or AVX-512 function of the operation.
+// The vectorized loops process the remaining elements after the last full vector with the scalar function.
+template <class Operation>
+void batch_binary_scalar(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = Operation::scalar(a[i], b[i], n);
+    }
+}
+
+template <class Operation>
+void batch_unary_scalar(const uint64_t *a, uint64_t *out, size_t len, uint64_t n)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = Operation::scalar(a[i], n);
+    }
+}
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+template <class Operation>
+__attribute__((target("avx2"))) void batch_binary_avx2(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n)
+{
+    const __m256i n_vector = _mm256_set1_epi64x(n);
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        const __m256i a_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i b_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), Operation::avx2(a_vector, b_vector, n_vector));
+    }
+    batch_binary_scalar<Operation>(a + i, b + i, out + i, len - i, n);
+}
+
+template <class Operation>
+__attribute__((target("avx2"))) void batch_unary_avx2(const uint64_t *a, uint64_t *out, size_t len, uint64_t n)
+{
+    const __m256i n_vector = _mm256_set1_epi64x(n);
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        const __m256i a_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), Operation::avx2(a_vector, n_vector));
+    }
+    batch_unary_scalar<Operation>(a + i, out + i, len - i, n);
+}
+
+template <class Operation>
+__attribute__((target("avx512f"))) void batch_binary_avx512(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n)
+{
+    const __m512i n_vector = _mm512_set1_epi64(n);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m512i a_vector = _mm512_loadu_si512(a + i);
+        const __m512i b_vector = _mm512_loadu_si512(b + i);
+        _mm512_storeu_si512(out + i, Operation::avx512(a_vector, b_vector, n_vector));
+    }
+    batch_binary_scalar<Operation>(a + i, b + i, out + i, len - i, n);
+}
+
+template <class Operation>
+__attribute__((target("avx512f"))) void batch_unary_avx512(const uint64_t *a, uint64_t *out, size_t len, uint64_t n)
+{
+    const __m512i n_vector = _mm512_set1_epi64(n);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m512i a_vector = _mm512_loadu_si512(a + i);
+        _mm512_storeu_si512(out + i, Operation::avx512(a_vector, n_vector));
+    }
+    batch_unary_scalar<Operation>(a + i, out + i, len - i, n);
+}
+#endif
+
+template <class Operation>
+void batch_binary(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n, BatchIsa isa)
+{
+    assert(n > 0);
+    switch (isa)
+    {
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    case BatchIsa::Avx512Ifma:
+    case BatchIsa::Avx512:
+        batch_binary_avx512<Operation>(a, b, out, len, n);
+        return;
+    case BatchIsa::Avx2:
+        batch_binary_avx2<Operation>(a, b, out, len, n);
+        return;
+#endif
+    default:
+        batch_binary_scalar<Operation>(a, b, out, len, n);
+    }
+}
+
+template <class Operation>
+void batch_unary(const uint64_t *a, uint64_t *out, size_t len, uint64_t n, BatchIsa isa)
+{
+    assert(n > 0);
+    switch (isa)
+    {
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    case BatchIsa::Avx512Ifma:
+    case BatchIsa::Avx512:
+        batch_unary_avx512<Operation>(a, out, len, n);
+        return;
+    case BatchIsa::Avx2:
+        batch_unary_avx2<Operation>(a, out, len, n);
+        return;
+#endif
+    default:
+        batch_unary_scalar<Operation>(a, out, len, n);
+    }
+}
+
+// This function computes out[i] = mod_add(a[i], b[i], n) for all i < len.
+inline void mod_add_batch(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_binary<BatchAddOperation>(a, b, out, len, n, isa);
+}
+
+// This function computes out[i] = mod_subtract(a[i], b[i], n) for all i < len.
+inline void mod_subtract_batch(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_binary<BatchSubtractOperation>(a, b, out, len, n, isa);
+}
+
+// This function computes out[i] = mod_additive_inverse(a[i], n) for all i < len.
+inline void mod_additive_inverse_batch(const uint64_t *a, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_unary<BatchAdditiveInverseOperation>(a, out, len, n, isa);
+}
+
+// This function computes out[i] = mod_increment(a[i], n) for all i < len.
+inline void mod_increment_batch(const uint64_t *a, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_unary<BatchIncrementOperation>(a, out, len, n, isa);
+}
+
+// This function computes out[i] = mod_decrement(a[i], n) for all i < len.
+inline void mod_decrement_batch(const uint64_t *a, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_unary<BatchDecrementOperation>(a, out, len, n, isa);
+}
+
+// Batch multiplication: out[i] = (a[i] * b[i]) % n, computed with Montgomery multiplication in the lanes.
+// The inputs and outputs are elements of Z_n (not in Montgomery form), so every product needs two Montgomery
+// multiplications: REDC(REDC(a * b) * R^2) = a * b, see MontgomeryContext.
+// Neither AVX2 nor AVX-512F have a 64x64->128 bit multiplication, so it is composed of four 32x32->64 bit products.
+// CPUs with AVX-512 IFMA multiply 52 bit numbers directly. For n < 2^52 this allows Montgomery multiplication
+// with R = 2^52, which needs only one instruction per partial product.
+// Montgomery multiplication requires an odd modulus, the scalar function is used for even moduli.
+
+// The constants of the Montgomery multiplication with R = 2^64 and R = 2^52 (for IFMA).
+struct BatchMontgomeryConstants
+{
+    explicit BatchMontgomeryConstants(uint64_t n)
+        : n(n)
+    {
+        assert(n & 0x1);
+        n_inv = n;
+        for (int i = 0; i < 5; i++)
+        {
+            n_inv *= 2 - n * n_inv;
+        }
+        const uint64_t r = (0 - n) % n;
+        r2 = static_cast<uint64_t>(static_cast<unsigned __int128>(r) * r % n);
+        if (n < (1UL << 52))
+        {
+            n_inv_52 = n_inv & ((1UL << 52) - 1);
+            r2_52 = static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 104) % n);
+        }
+    }
+
+    uint64_t n;
+    uint64_t n_inv = 0;    // n^-1 % 2^64
+    uint64_t r2 = 0;       // 2^128 % n
+    uint64_t n_inv_52 = 0; // n^-1 % 2^52
+    uint64_t r2_52 = 0;    // 2^104 % n
+};
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+// Computes the lower and upper 64 bits of the 128 bit products of the lanes.
+__attribute__((target("avx2"))) inline void multiply_wide_avx2(__m256i a, __m256i b, __m256i &low, __m256i &high)
+{
+    const __m256i mask = _mm256_set1_epi64x(0xffffffff);
+    const __m256i a_high = _mm256_srli_epi64(a, 32);
+    const __m256i b_high = _mm256_srli_epi64(b, 32);
+    const __m256i p00 = _mm256_mul_epu32(a, b);
+    const __m256i p01 = _mm256_mul_epu32(a, b_high);
+    const __m256i p10 = _mm256_mul_epu32(a_high, b);
+    const __m256i p11 = _mm256_mul_epu32(a_high, b_high);
+    const __m256i middle = _mm256_add_epi64(_mm256_add_epi64(_mm256_srli_epi64(p00, 32), _mm256_and_si256(p01, mask)), _mm256_and_si256(p10, mask));
+    low = _mm256_or_si256(_mm256_slli_epi64(middle, 32), _mm256_and_si256(p00, mask));
+    high = _mm256_add_epi64(_mm256_add_epi64(p11, _mm256_srli_epi64(p01, 32)), _mm256_add_epi64(_mm256_srli_epi64(p10, 32), _mm256_srli_epi64(middle, 32)));
+}
+
+// Computes the lower 64 bits of the products of the lanes.
+__attribute__((target("avx2"))) inline __m256i multiply_low_avx2(__m256i a, __m256i b)
+{
+    const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)), _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+}
+
+// Computes the upper 64 bits of the products of the lanes.
+__attribute__((target("avx2"))) inline __m256i multiply_high_avx2(__m256i a, __m256i b)
+{
+    const __m256i mask = _mm256_set1_epi64x(0xffffffff);
+    const __m256i a_high = _mm256_srli_epi64(a, 32);
+    const __m256i b_high = _mm256_srli_epi64(b, 32);
+    const __m256i p01 = _mm256_mul_epu32(a, b_high);
+    const __m256i p10 = _mm256_mul_epu32(a_high, b);
+    const __m256i middle = _mm256_add_epi64(_mm256_add_epi64(_mm256_srli_epi64(_mm256_mul_epu32(a, b), 32), _mm256_and_si256(p01, mask)), _mm256_and_si256(p10, mask));
+    return _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(a_high, b_high), _mm256_srli_epi64(p01, 32)), _mm256_add_epi64(_mm256_srli_epi64(p10, 32), _mm256_srli_epi64(middle, 32)));
+}
+
+// Computes REDC(a * b) in every lane, the same as MontgomeryContext::multiply.
+__attribute__((target("avx2"))) inline __m256i montgomery_multiply_avx2(__m256i a, __m256i b, __m256i n, __m256i n_inv)
+{
+    __m256i t_low;
+    __m256i t_high;
+    multiply_wide_avx2(a, b, t_low, t_high);
+    const __m256i mn_high = multiply_high_avx2(multiply_low_avx2(t_low, n_inv), n);
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i less = _mm256_cmpgt_epi64(_mm256_xor_si256(mn_high, sign), _mm256_xor_si256(t_high, sign));
+    return _mm256_add_epi64(_mm256_sub_epi64(t_high, mn_high), _mm256_and_si256(less, n));
+}
+
+__attribute__((target("avx512f"))) inline void multiply_wide_avx512(__m512i a, __m512i b, __m512i &low, __m512i &high)
+{
+    const __m512i mask = _mm512_set1_epi64(0xffffffff);
+    const __m512i a_high = _mm512_srli_epi64(a, 32);
+    const __m512i b_high = _mm512_srli_epi64(b, 32);
+    const __m512i p00 = _mm512_mul_epu32(a, b);
+    const __m512i p01 = _mm512_mul_epu32(a, b_high);
+    const __m512i p10 = _mm512_mul_epu32(a_high, b);
+    const __m512i p11 = _mm512_mul_epu32(a_high, b_high);
+    const __m512i middle = _mm512_add_epi64(_mm512_add_epi64(_mm512_srli_epi64(p00, 32), _mm512_and_si512(p01, mask)), _mm512_and_si512(p10, mask));
+    low = _mm512_or_si512(_mm512_slli_epi64(middle, 32), _mm512_and_si512(p00, mask));
+    high = _mm512_add_epi64(_mm512_add_epi64(p11, _mm512_srli_epi64(p01, 32)), _mm512_add_epi64(_mm512_srli_epi64(p10, 32), _mm512_srli_epi64(middle, 32)));
+}
+
+__attribute__((target("avx512f"))) inline __m512i multiply_low_avx512(__m512i a, __m512i b)
+{
+    const __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(a, _mm512_srli_epi64(b, 32)), _mm512_mul_epu32(_mm512_srli_epi64(a, 32), b));
+    return _mm512_add_epi64(_mm512_mul_epu32(a, b), _mm512_slli_epi64(cross, 32));
+}
+
+// Computes the upper 64 bits of the products of the lanes.
+__attribute__((target("avx512f"))) inline __m512i multiply_high_avx512(__m512i a, __m512i b)
+{
+    const __m512i mask = _mm512_set1_epi64(0xffffffff);
+    const __m512i a_high = _mm512_srli_epi64(a, 32);
+    const __m512i b_high = _mm512_srli_epi64(b, 32);
+    const __m512i p01 = _mm512_mul_epu32(a, b_high);
+    const __m512i p10 = _mm512_mul_epu32(a_high, b);
+    const __m512i middle = _mm512_add_epi64(_mm512_add_epi64(_mm512_srli_epi64(_mm512_mul_epu32(a, b), 32), _mm512_and_si512(p01, mask)), _mm512_and_si512(p10, mask));
+    return _mm512_add_epi64(_mm512_add_epi64(_mm512_mul_epu32(a_high, b_high), _mm512_srli_epi64(p01, 32)), _mm512_add_epi64(_mm512_srli_epi64(p10, 32), _mm512_srli_epi64(middle, 32)));
+}
+
+__attribute__((target("avx512f"))) inline __m512i montgomery_multiply_avx512(__m512i a, __m512i b, __m512i n, __m512i n_inv)
+{
+    __m512i t_low;
+    __m512i t_high;
+    multiply_wide_avx512(a, b, t_low, t_high);
+    const __m512i mn_high = multiply_high_avx512(multiply_low_avx512(t_low, n_inv), n);
+    const __m512i difference = _mm512_sub_epi64(t_high, mn_high);
+    return _mm512_mask_add_epi64(difference, _mm512_cmplt_epu64_mask(t_high, mn_high), difference, n);
+}
+
+// Computes REDC(a * b) with R = 2^52 in every lane, requires n < 2^52.
+// madd52lo and madd52hi return the lower and upper 52 bits of the 104 bit product of two 52 bit numbers.
+__attribute__((target("avx512f,avx512ifma"))) inline __m512i montgomery_multiply_avx512_ifma(__m512i a, __m512i b, __m512i n, __m512i n_inv)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i t_low = _mm512_madd52lo_epu64(zero, a, b);
+    const __m512i t_high = _mm512_madd52hi_epu64(zero, a, b);
+    const __m512i m = _mm512_madd52lo_epu64(zero, t_low, n_inv);
+    const __m512i mn_high = _mm512_madd52hi_epu64(zero, m, n);
+    const __m512i difference = _mm512_sub_epi64(t_high, mn_high);
+    return _mm512_mask_add_epi64(difference, _mm512_cmplt_epu64_mask(t_high, mn_high), difference, n);
+}
+#endif
+
+// Computes out[i] = (a[i] * b[i] + c[i]) % n, or out[i] = (a[i] * b[i]) % n if c is nullptr.
+inline void batch_multiply_scalar(const uint64_t *a, const uint64_t *b, const uint64_t *c, uint64_t *out, size_t len, uint64_t n)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        const uint64_t product = mod_multiply(a[i], b[i], n);
+        out[i] = c ? mod_add(product, c[i], n) : product;
+    }
+}
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+__attribute__((target("avx2"))) inline void batch_multiply_avx2(const uint64_t *a, const uint64_t *b, const uint64_t *c, uint64_t *out, size_t len, const BatchMontgomeryConstants &constants)
+{
+    const __m256i n = _mm256_set1_epi64x(constants.n);
+    const __m256i n_inv = _mm256_set1_epi64x(constants.n_inv);
+    const __m256i r2 = _mm256_set1_epi64x(constants.r2);
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        const __m256i a_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i b_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i product = montgomery_multiply_avx2(montgomery_multiply_avx2(a_vector, b_vector, n, n_inv), r2, n, n_inv);
+        if (c)
+        {
+            product = BatchAddOperation::avx2(product, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + i)), n);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), product);
+    }
+    batch_multiply_scalar(a + i, b + i, c ? c + i : nullptr, out + i, len - i, constants.n);
+}
+
+__attribute__((target("avx512f"))) inline void batch_multiply_avx512(const uint64_t *a, const uint64_t *b, const uint64_t *c, uint64_t *out, size_t len, const BatchMontgomeryConstants &constants)
+{
+    const __m512i n = _mm512_set1_epi64(constants.n);
+    const __m512i n_inv = _mm512_set1_epi64(constants.n_inv);
+    const __m512i r2 = _mm512_set1_epi64(constants.r2);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m512i a_vector = _mm512_loadu_si512(a + i);
+        const __m512i b_vector = _mm512_loadu_si512(b + i);
+        __m512i product = montgomery_multiply_avx512(montgomery_multiply_avx512(a_vector, b_vector, n, n_inv), r2, n, n_inv);
+        if (c)
+        {
+            product = BatchAddOperation::avx512(product, _mm512_loadu_si512(c + i), n);
+        }
+        _mm512_storeu_si512(out + i, product);
+    }
+    batch_multiply_scalar(a + i, b + i, c ? c + i : nullptr, out + i, len - i, constants.n);
+}
+
+__attribute__((target("avx512f,avx512ifma"))) inline void batch_multiply_avx512_ifma(const uint64_t *a, const uint64_t *b, const uint64_t *c, uint64_t *out, size_t len, const BatchMontgomeryConstants &constants)
+{
+    const __m512i n = _mm512_set1_epi64(constants.n);
+    const __m512i n_inv = _mm512_set1_epi64(constants.n_inv_52);
+    const __m512i r2 = _mm512_set1_epi64(constants.r2_52);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m512i a_vector = _mm512_loadu_si512(a + i);
+        const __m512i b_vector = _mm512_loadu_si512(b + i);
+        __m512i product = montgomery_multiply_avx512_ifma(montgomery_multiply_avx512_ifma(a_vector, b_vector, n, n_inv), r2, n, n_inv);
+        if (c)
+        {
+            product = BatchAddOperation::avx512(product, _mm512_loadu_si512(c + i), n);
+        }
+        _mm512_storeu_si512(out + i, product);
+    }
+    batch_multiply_scalar(a + i, b + i, c ? c + i : nullptr, out + i, len - i, constants.n);
+}
+#endif
+
+inline void batch_multiply(const uint64_t *a, const uint64_t *b, const uint64_t *c, uint64_t *out, size_t len, uint64_t n, BatchIsa isa)
+{
+    assert(n > 0);
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    if (isa != BatchIsa::Scalar && (n & 0x1))
+    {
+        const BatchMontgomeryConstants constants(n);
+        switch (isa)
+        {
+        case BatchIsa::Avx512Ifma:
+            if (n < (1UL << 52))
+            {
+                batch_multiply_avx512_ifma(a, b, c, out, len, constants);
+                return;
+            }
+            batch_multiply_avx512(a, b, c, out, len, constants);
+            return;
+        case BatchIsa::Avx512:
+            batch_multiply_avx512(a, b, c, out, len, constants);
+            return;
+        default:
+            batch_multiply_avx2(a, b, c, out, len, constants);
+            return;
+        }
+    }
+#endif
+    batch_multiply_scalar(a, b, c, out, len, n);
+}
+
+// This function computes out[i] = mod_multiply(a[i], b[i], n) for all i < len.
+inline void mod_multiply_batch(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_multiply(a, b, nullptr, out, len, n, isa);
+}
+
+// This function computes out[i] = mod_sqr(a[i], n) for all i < len.
+inline void mod_sqr_batch(const uint64_t *a, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_multiply(a, a, nullptr, out, len, n, isa);
+}
+
+// This function computes out[i] = mod_add(mod_multiply(a[i], b[i], n), c[i], n) for all i < len.
+inline void mod_multiply_add_batch(const uint64_t *a, const uint64_t *b, const uint64_t *c, uint64_t *out, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    batch_multiply(a, b, c, out, len, n, isa);
+}
+
+// Batch multiplication with a constant: out[i] = (a[i] * w) % n with Shoup's multiplication, see ShoupMultiplier.
+// Contrarily to mod_multiply_batch, no Montgomery conversion is needed, so a product costs one high and two low
+// multiplications in the lanes, plus one compare and select.
+
+// Computes out[i] = multiplier.multiply(a[i]).
+inline void batch_multiply_constant_scalar(const uint64_t *a, uint64_t *out, size_t len, const ShoupMultiplier &multiplier)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        out[i] = multiplier.multiply(a[i]);
+    }
+}
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+__attribute__((target("avx2"))) inline void batch_multiply_constant_avx2(const uint64_t *a, uint64_t *out, size_t len, const ShoupMultiplier &multiplier)
+{
+    const __m256i w = _mm256_set1_epi64x(multiplier.multiplier());
+    const __m256i w_quotient = _mm256_set1_epi64x(multiplier.quotient());
+    const __m256i n = _mm256_set1_epi64x(multiplier.modulus());
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i n_minus_one = _mm256_xor_si256(_mm256_set1_epi64x(multiplier.modulus() - 1), sign);
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        const __m256i a_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        const __m256i q = multiply_high_avx2(a_vector, w_quotient);
+        const __m256i r = _mm256_sub_epi64(multiply_low_avx2(a_vector, w), multiply_low_avx2(q, n));
+        const __m256i greater = _mm256_cmpgt_epi64(_mm256_xor_si256(r, sign), n_minus_one);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_sub_epi64(r, _mm256_and_si256(greater, n)));
+    }
+    batch_multiply_constant_scalar(a + i, out + i, len - i, multiplier);
+}
+
+__attribute__((target("avx512f"))) inline void batch_multiply_constant_avx512(const uint64_t *a, uint64_t *out, size_t len, const ShoupMultiplier &multiplier)
+{
+    const __m512i w = _mm512_set1_epi64(multiplier.multiplier());
+    const __m512i w_quotient = _mm512_set1_epi64(multiplier.quotient());
+    const __m512i n = _mm512_set1_epi64(multiplier.modulus());
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        const __m512i a_vector = _mm512_loadu_si512(a + i);
+        const __m512i q = multiply_high_avx512(a_vector, w_quotient);
+        const __m512i r = _mm512_sub_epi64(multiply_low_avx512(a_vector, w), multiply_low_avx512(q, n));
+        _mm512_storeu_si512(out + i, _mm512_mask_sub_epi64(r, _mm512_cmpge_epu64_mask(r, n), r, n));
+    }
+    batch_multiply_constant_scalar(a + i, out + i, len - i, multiplier);
+}
+#endif
+
+// This function computes out[i] = (a[i] * w) % n for all i < len, where multiplier = ShoupMultiplier(w, n).
+// The inputs a[i] can be any 64 bit numbers, n has to be smaller than 2^63.
+inline void mod_multiply_constant_batch(const uint64_t *a, uint64_t *out, size_t len, const ShoupMultiplier &multiplier, BatchIsa isa = detect_batch_isa())
+{
+    switch (isa)
+    {
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    case BatchIsa::Avx512Ifma:
+    case BatchIsa::Avx512:
+        batch_multiply_constant_avx512(a, out, len, multiplier);
+        return;
+    case BatchIsa::Avx2:
+        batch_multiply_constant_avx2(a, out, len, multiplier);
+        return;
+#endif
+    default:
+        batch_multiply_constant_scalar(a, out, len, multiplier);
+    }
+}
+
+// Batch dot product: the same as mod_dot, but the products are summed up in the lanes without reduction.
+// For n <= 2^32, the elements have 32 bits, so the 64 bit product of two lanes is a single mul_epu32 instruction.
+// Its lower and upper 32 bits are summed up in separate lanes, so a lane can take 2^32 products without overflow.
+// For n <= 2^52, AVX-512 IFMA adds the lower and upper 52 bits of the 104 bit product to a lane in one instruction
+// (madd52lo and madd52hi), so a lane can take 2^12 products. The IFMA loop uses 4 independent accumulators,
+// which hides the latency of the instructions.
+// The lanes are added up and reduced before they could overflow, so there is one 128 bit reduction per flush.
+// Larger moduli use the scalar mod_dot, since a 64x64->128 bit product needs four multiplications in the lanes.
+
+// Returns (sum + ((high[0] + ...) << shift) + low[0] + ...) % n for the lanes low and high.
+inline uint64_t batch_dot_flush(uint64_t sum, const uint64_t *low, const uint64_t *high, size_t lanes, int shift, uint64_t n)
+{
+    unsigned __int128 low_sum = 0;
+    unsigned __int128 high_sum = 0;
+    for (size_t l = 0; l < lanes; l++)
+    {
+        low_sum += low[l];
+        high_sum += high[l];
+    }
+    return mod_add(sum, static_cast<uint64_t>(((high_sum << shift) + low_sum) % n), n);
+}
+
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+// Requires n <= 2^32.
+__attribute__((target("avx2"))) inline uint64_t batch_dot_avx2(const uint64_t *a, const uint64_t *b, size_t len, uint64_t n)
+{
+    constexpr size_t flush_interval = 4 << 24;
+    const __m256i mask = _mm256_set1_epi64x(0xffffffff);
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (len - i >= 4)
+    {
+        __m256i low = _mm256_setzero_si256();
+        __m256i high = _mm256_setzero_si256();
+        const size_t end = i + std::min(flush_interval, (len - i) & ~static_cast<size_t>(3));
+        for (; i < end; i += 4)
+        {
+            const __m256i product = _mm256_mul_epu32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)),
+                                                     _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+            low = _mm256_add_epi64(low, _mm256_and_si256(product, mask));
+            high = _mm256_add_epi64(high, _mm256_srli_epi64(product, 32));
+        }
+        alignas(32) uint64_t low_lanes[4];
+        alignas(32) uint64_t high_lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(low_lanes), low);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(high_lanes), high);
+        sum = batch_dot_flush(sum, low_lanes, high_lanes, 4, 32, n);
+    }
+    return mod_add(sum, mod_dot(a + i, b + i, len - i, n), n);
+}
+
+// Requires n <= 2^32.
+__attribute__((target("avx512f"))) inline uint64_t batch_dot_avx512(const uint64_t *a, const uint64_t *b, size_t len, uint64_t n)
+{
+    constexpr size_t flush_interval = 8 << 24;
+    const __m512i mask = _mm512_set1_epi64(0xffffffff);
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (len - i >= 8)
+    {
+        __m512i low = _mm512_setzero_si512();
+        __m512i high = _mm512_setzero_si512();
+        const size_t end = i + std::min(flush_interval, (len - i) & ~static_cast<size_t>(7));
+        for (; i < end; i += 8)
+        {
+            const __m512i product = _mm512_mul_epu32(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+            low = _mm512_add_epi64(low, _mm512_and_si512(product, mask));
+            high = _mm512_add_epi64(high, _mm512_srli_epi64(product, 32));
+        }
+        alignas(64) uint64_t low_lanes[8];
+        alignas(64) uint64_t high_lanes[8];
+        _mm512_store_si512(low_lanes, low);
+        _mm512_store_si512(high_lanes, high);
+        sum = batch_dot_flush(sum, low_lanes, high_lanes, 8, 32, n);
+    }
+    return mod_add(sum, mod_dot(a + i, b + i, len - i, n), n);
+}
+
+// Requires n <= 2^52.
+__attribute__((target("avx512f,avx512ifma"))) inline uint64_t batch_dot_avx512_ifma(const uint64_t *a, const uint64_t *b, size_t len, uint64_t n)
+{
+    constexpr size_t flush_interval = 32 << 12;
+    uint64_t sum = 0;
+    size_t i = 0;
+    while (len - i >= 32)
+    {
+        __m512i low[4];
+        __m512i high[4];
+        for (int u = 0; u < 4; u++)
+        {
+            low[u] = _mm512_setzero_si512();
+            high[u] = _mm512_setzero_si512();
+        }
+        const size_t end = i + std::min(flush_interval, (len - i) & ~static_cast<size_t>(31));
+        for (; i < end; i += 32)
+        {
+            for (int u = 0; u < 4; u++)
+            {
+                const __m512i a_vector = _mm512_loadu_si512(a + i + 8 * u);
+                const __m512i b_vector = _mm512_loadu_si512(b + i + 8 * u);
+                low[u] = _mm512_madd52lo_epu64(low[u], a_vector, b_vector);
+                high[u] = _mm512_madd52hi_epu64(high[u], a_vector, b_vector);
+            }
+        }
+        alignas(64) uint64_t low_lanes[32];
+        alignas(64) uint64_t high_lanes[32];
+        for (int u = 0; u < 4; u++)
+        {
+            _mm512_store_si512(low_lanes + 8 * u, low[u]);
+            _mm512_store_si512(high_lanes + 8 * u, high[u]);
+        }
+        sum = batch_dot_flush(sum, low_lanes, high_lanes, 32, 52, n);
+    }
+    return mod_add(sum, mod_dot(a + i, b + i, len - i, n), n);
+}
+#endif
+
+// This function computes mod_dot(a, b, len, n), the result is the same for all instruction sets.
+inline uint64_t mod_dot_batch(const uint64_t *a, const uint64_t *b, size_t len, uint64_t n, BatchIsa isa = detect_batch_isa())
+{
+    assert(n > 0);
+#if defined(MODULAR_ARITHMETIC_BATCH_X86)
+    // mul_epu32 needs fewer instructions per product than madd52lo and madd52hi.
+    if ((isa == BatchIsa::Avx512Ifma || isa == BatchIsa::Avx512) && n <= (1UL << 32))
+    {
+        return batch_dot_avx512(a, b, len, n);
+    }
+    if (isa == BatchIsa::Avx512Ifma && n <= (1UL << 52))
+    {
+        return batch_dot_avx512_ifma(a, b, len, n);
+    }
+    if (isa == BatchIsa::Avx2 && n <= (1UL << 32))
+    {
+        return batch_dot_avx2(a, b, len, n);
+    }
+#endif
+    return mod_dot(a, b, len, n);
+}
@@ -0,0 +1,1125 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binomial_table.h"
+#include "modular_arithmetic.h"
+#include "modular_arithmetic_batch.h"
+#include "modular_matrix.h"
+#include "multi_precision.h"
+#include "number_theoretic_transform.h"
+#include "number_theory.h"
+#include "rolling_hash.h"
+
+// This benchmark compares the different implementations of the functions in modular_arithmetic.h.
+// Every measurement runs a function over a set of random inputs and reports the time per call.
+
+// Prevents the compiler from removing the benchmarked calls.
+static volatile uint64_t sink;
+
+// Runs function(i) for all i < count and returns the time per call in nanoseconds.
+template <class Function>
+double measure(size_t count, Function function)
+{
+    uint64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        checksum ^= function(i);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    sink = checksum;
+    return std::chrono::duration<double, std::nano>(stop - start).count() / count;
+}
+
+// Runs function() repetitions times and returns the time per element in nanoseconds.
+template <class Function>
+double measure_batch(size_t len, size_t repetitions, Function function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repetitions; i++)
+    {
+        function();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (len * repetitions);
+}
+
+void print_result(const std::string &primitive, const std::string &implementation, double nanoseconds, double baseline)
+{
+    std::cout << std::left << std::setw(28) << primitive << std::setw(20) << implementation
+              << std::right << std::fixed << std::setprecision(2) << std::setw(12) << nanoseconds << " ns/op"
+              << std::setw(10) << baseline / nanoseconds << "x" << std::endl;
+}
+
+std::vector<uint64_t> random_residues(size_t count, uint64_t n, std::mt19937_64 &generator)
+{
+    std::vector<uint64_t> values(count);
+    for (uint64_t &value : values)
+    {
+        value = generator() % n;
+    }
+    return values;
+}
+
+// Compares the kernels of mod_multiply, mod_sqr, mod_power and mod_multiplicative_inverse,
+// as well as MontgomeryContext and BarrettReducer.
+void benchmark_multiply_kernels()
+{
+    // The largest prime below 2^64 (odd, so that Montgomery multiplication is applicable).
+    const uint64_t n = 18446744073709551557UL;
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 16;
+    const std::vector<uint64_t> a = random_residues(count, n, generator);
+    const std::vector<uint64_t> b = random_residues(count, n, generator);
+    const MontgomeryContext montgomery(n);
+    const BarrettReducer barrett(n);
+
+    std::cout << "Speedup relative to the double and add kernel, modulus " << n << ":" << std::endl;
+
+    const double multiply_baseline = measure(count, [&](size_t i) { return mod_multiply<DoubleAndAddKernel>(a[i], b[i], n); });
+    print_result("mod_multiply", "double and add", multiply_baseline, multiply_baseline);
+#if defined(__SIZEOF_INT128__)
+    print_result("mod_multiply", "__int128", measure(count, [&](size_t i) { return mod_multiply<Int128Kernel>(a[i], b[i], n); }), multiply_baseline);
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    print_result("mod_multiply", "intrinsic", measure(count, [&](size_t i) { return mod_multiply<IntrinsicKernel>(a[i], b[i], n); }), multiply_baseline);
+#endif
+    print_result("mod_multiply", "Barrett", measure(count, [&](size_t i) { return barrett.multiply(a[i], b[i]); }), multiply_baseline);
+    // Operands in Montgomery form, the conversion is not part of the hot path.
+    print_result("mod_multiply", "Montgomery", measure(count, [&](size_t i) { return montgomery.multiply(a[i], b[i]); }), multiply_baseline);
+
+    const double sqr_baseline = measure(count, [&](size_t i) { return mod_sqr<DoubleAndAddKernel>(a[i], n); });
+    print_result("mod_sqr", "double and add", sqr_baseline, sqr_baseline);
+#if defined(__SIZEOF_INT128__)
+    print_result("mod_sqr", "__int128", measure(count, [&](size_t i) { return mod_sqr<Int128Kernel>(a[i], n); }), sqr_baseline);
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    print_result("mod_sqr", "intrinsic", measure(count, [&](size_t i) { return mod_sqr<IntrinsicKernel>(a[i], n); }), sqr_baseline);
+#endif
+
+    // Exponentiations are a lot slower, so fewer inputs are used.
+    const size_t power_count = 1 << 10;
+    const double power_baseline = measure(power_count, [&](size_t i) { return mod_power<DoubleAndAddKernel>(a[i], b[i], n); });
+    print_result("mod_power", "double and add", power_baseline, power_baseline);
+#if defined(__SIZEOF_INT128__)
+    print_result("mod_power", "__int128", measure(power_count, [&](size_t i) { return mod_power<Int128Kernel>(a[i], b[i], n); }), power_baseline);
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    print_result("mod_power", "intrinsic", measure(power_count, [&](size_t i) { return mod_power<IntrinsicKernel>(a[i], b[i], n); }), power_baseline);
+#endif
+    print_result("mod_power", "Barrett", measure(power_count, [&](size_t i) { return barrett.power(a[i], b[i]); }), power_baseline);
+    print_result("mod_power", "Montgomery", measure(power_count, [&](size_t i) { return montgomery.power(a[i], b[i]); }), power_baseline);
+
+    const double inverse_baseline = measure(power_count, [&](size_t i) { return mod_multiplicative_inverse<DoubleAndAddKernel>(a[i], n); });
+    print_result("mod_multiplicative_inverse", "double and add", inverse_baseline, inverse_baseline);
+#if defined(__SIZEOF_INT128__)
+    print_result("mod_multiplicative_inverse", "__int128", measure(power_count, [&](size_t i) { return mod_multiplicative_inverse<Int128Kernel>(a[i], n); }), inverse_baseline);
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    print_result("mod_multiplicative_inverse", "intrinsic", measure(power_count, [&](size_t i) { return mod_multiplicative_inverse<IntrinsicKernel>(a[i], n); }), inverse_baseline);
+#endif
+    std::cout << std::endl;
+}
+
+// Compares the reduction of a modulus policy to the generic reductions for the same modulus.
+template <class Modulus>
+void benchmark_special_modulus(const std::string &name)
+{
+    const uint64_t n = Modulus::modulus;
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 16;
+    const std::vector<uint64_t> a = random_residues(count, n, generator);
+    const std::vector<uint64_t> b = random_residues(count, n, generator);
+    std::vector<unsigned __int128> x(count);
+    for (unsigned __int128 &value : x)
+    {
+        value = (static_cast<unsigned __int128>(generator()) << 64) | generator();
+    }
+    const MontgomeryContext montgomery(n);
+    const BarrettReducer barrett(n);
+
+    std::cout << "Speedup of " << name << " relative to the intrinsic kernel, modulus " << n << ":" << std::endl;
+
+    const double multiply_baseline = measure(count, [&](size_t i) { return mod_multiply(a[i], b[i], n); });
+    print_result("mod_multiply", "intrinsic", multiply_baseline, multiply_baseline);
+    print_result("mod_multiply", "Barrett", measure(count, [&](size_t i) { return barrett.multiply(a[i], b[i]); }), multiply_baseline);
+    print_result("mod_multiply", "Montgomery", measure(count, [&](size_t i) { return montgomery.multiply(a[i], b[i]); }), multiply_baseline);
+    print_result("mod_multiply", name, measure(count, [&](size_t i) { return mod_multiply<Modulus>(a[i], b[i]); }), multiply_baseline);
+
+    const size_t power_count = 1 << 10;
+    const double power_baseline = measure(power_count, [&](size_t i) { return mod_power(a[i], b[i], n); });
+    print_result("mod_power", "intrinsic", power_baseline, power_baseline);
+    print_result("mod_power", "Montgomery", measure(power_count, [&](size_t i) { return montgomery.power(a[i], b[i]); }), power_baseline);
+    print_result("mod_power", name, measure(power_count, [&](size_t i) { return mod_power<Modulus>(a[i], b[i]); }), power_baseline);
+
+    const double reduce_baseline = measure(count, [&](size_t i) { return static_cast<uint64_t>(x[i] % n); });
+    print_result("reduce 128 bit", "__int128", reduce_baseline, reduce_baseline);
+    print_result("reduce 128 bit", "Barrett", measure(count, [&](size_t i) { return barrett.reduce(x[i]); }), reduce_baseline);
+    print_result("reduce 128 bit", name, measure(count, [&](size_t i) { return mod_reduce<Modulus>(x[i]); }), reduce_baseline);
+    std::cout << std::endl;
+}
+
+// A kernel which counts the number of multiplications.
+struct CountingKernel
+{
+    static uint64_t multiply(uint64_t a, uint64_t b, uint64_t n)
+    {
+        count++;
+        return DefaultMultiplyKernel::multiply(a, b, n);
+    }
+
+    static inline uint64_t count = 0;
+};
+
+// Compares mod_power to mod_power_sliding_window for exponents of different sizes.
+// The sliding window saves multiplications, but all of them depend on each other. In mod_power, the multiplications
+// y *= z and the squarings z *= z are independent, so they can run in parallel on an out of order CPU.
+void benchmark_sliding_window()
+{
+    const uint64_t n = 18446744073709551557UL;
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 12;
+    const std::vector<uint64_t> a = random_residues(count, n, generator);
+
+    std::cout << "Speedup of sliding window exponentiation relative to mod_power, modulus " << n << ":" << std::endl;
+    for (const int bits : {8, 16, 24, 32, 48, 64})
+    {
+        // Random exponents with exactly the given number of bits.
+        std::vector<uint64_t> e(count);
+        for (uint64_t &exponent : e)
+        {
+            exponent = (generator() >> (64 - bits)) | (1UL << (bits - 1));
+        }
+        const std::string primitive = "mod_power, " + std::to_string(bits) + " bit exponent";
+        const double baseline = measure(count, [&](size_t i) { return mod_power(a[i], e[i], n); });
+        print_result(primitive, "binary", baseline, baseline);
+        print_result(primitive, "sliding window", measure(count, [&](size_t i) { return mod_power_sliding_window(a[i], e[i], n); }), baseline);
+
+        CountingKernel::count = 0;
+        measure(count, [&](size_t i) { return mod_power<CountingKernel>(a[i], e[i], n); });
+        const double binary_multiplications = static_cast<double>(CountingKernel::count) / count;
+        CountingKernel::count = 0;
+        measure(count, [&](size_t i) { return mod_power_sliding_window<CountingKernel>(a[i], e[i], n); });
+        const double sliding_window_multiplications = static_cast<double>(CountingKernel::count) / count;
+        std::cout << std::left << std::setw(48) << "  multiplications (binary, sliding window)" << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << binary_multiplications << std::setw(10) << sliding_window_multiplications << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Compares mod_power to FixedBasePower with different window widths (and table sizes).
+void benchmark_fixed_base()
+{
+    const uint64_t n = 18446744073709551557UL;
+    const uint64_t a = 7829454892340959985UL;
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 12;
+    const std::vector<uint64_t> e = random_residues(count, n, generator);
+
+    std::cout << "Speedup of fixed base exponentiation relative to mod_power, modulus " << n << ":" << std::endl;
+    const double baseline = measure(count, [&](size_t i) { return mod_power(a, e[i], n); });
+    print_result("mod_power", "binary", baseline, baseline);
+    for (const int window_bits : {1, 2, 4, 6, 8, 11, 16})
+    {
+        const FixedBasePower<> fixed_base(a, n, window_bits);
+        const std::string implementation = "w = " + std::to_string(window_bits) + ", " + std::to_string(fixed_base.table_size() * sizeof(uint64_t) / 1024) + " KiB";
+        print_result("FixedBasePower::power", implementation, measure(count, [&](size_t i) { return fixed_base.power(e[i]); }), baseline);
+    }
+    std::cout << std::endl;
+}
+
+// Compares mod_multi_power to separate calls of mod_power, followed by mod_multiply.
+// As for the sliding window, the separate calls of mod_power are independent of each other and can overlap on an
+// out of order CPU, while the multiplications of mod_multi_power form one dependency chain.
+void benchmark_multi_power()
+{
+    const uint64_t n = 18446744073709551557UL;
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 10;
+
+    std::cout << "Speedup of multi-exponentiation relative to mod_power and mod_multiply, modulus " << n << ":" << std::endl;
+    for (const size_t bases_count : {2, 3, 4, 8})
+    {
+        const std::vector<uint64_t> bases = random_residues(count * bases_count, n, generator);
+        const std::vector<uint64_t> exponents = random_residues(count * bases_count, n, generator);
+        const std::string primitive = std::to_string(bases_count) + " bases";
+        const double baseline = measure(count, [&](size_t i)
+                                        {
+                                            uint64_t product = mod_power(bases[i * bases_count], exponents[i * bases_count], n);
+                                            for (size_t j = 1; j < bases_count; j++)
+                                            {
+                                                product = mod_multiply(product, mod_power(bases[i * bases_count + j], exponents[i * bases_count + j], n), n);
+                                            }
+                                            return product; });
+        print_result(primitive, "mod_power", baseline, baseline);
+        print_result(primitive, "mod_multi_power", measure(count, [&](size_t i) { return mod_multi_power(&bases[i * bases_count], &exponents[i * bases_count], bases_count, n); }), baseline);
+
+        CountingKernel::count = 0;
+        measure(count, [&](size_t i)
+                {
+                    uint64_t product = mod_power<CountingKernel>(bases[i * bases_count], exponents[i * bases_count], n);
+                    for (size_t j = 1; j < bases_count; j++)
+                    {
+                        product = mod_multiply<CountingKernel>(product, mod_power<CountingKernel>(bases[i * bases_count + j], exponents[i * bases_count + j], n), n);
+                    }
+                    return product; });
+        const double separate_multiplications = static_cast<double>(CountingKernel::count) / count;
+        CountingKernel::count = 0;
+        measure(count, [&](size_t i) { return mod_multi_power<CountingKernel>(&bases[i * bases_count], &exponents[i * bases_count], bases_count, n); });
+        const double multi_power_multiplications = static_cast<double>(CountingKernel::count) / count;
+        std::cout << std::left << std::setw(48) << "  multiplications (separate, multi power)" << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << separate_multiplications << std::setw(10) << multi_power_multiplications << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Compares mod_inverse_batch to a loop over mod_multiplicative_inverse.
+void benchmark_inverse_batch()
+{
+    const uint64_t n = 9223372036854775337UL;
+    std::mt19937_64 generator(42);
+    const size_t len = 1 << 16;
+    const std::vector<uint64_t> in = random_residues(len, n, generator);
+    std::vector<uint64_t> out(len);
+
+    std::cout << "Speedup of batch inversion relative to mod_multiplicative_inverse, " << len << " elements, modulus " << n << ":" << std::endl;
+    const double baseline = measure_batch(len, 1, [&]()
+                                          {
+                                              for (size_t i = 0; i < len; i++)
+                                              {
+                                                  out[i] = mod_multiplicative_inverse(in[i], n);
+                                              }
+                                              sink = out[len - 1]; });
+    print_result("inverse", "Fermat loop", baseline, baseline);
+    print_result("mod_inverse_batch", "1 thread", measure_batch(len, 10, [&]()
+                                                                { mod_inverse_batch(in.data(), out.data(), len, n); }),
+                 baseline);
+    const size_t threads = std::thread::hardware_concurrency();
+    if (threads > 1)
+    {
+        print_result("mod_inverse_batch", std::to_string(threads) + " threads", measure_batch(len, 10, [&]()
+                                                                                             { mod_inverse_batch(in.data(), out.data(), len, n, threads); }),
+                     baseline);
+    }
+    std::cout << std::endl;
+}
+
+// Compares the inversion algorithms: Fermat's little theorem (mod_multiplicative_inverse, prime moduli only),
+// the extended Euclidean algorithm (moduli below 2^63 only), the binary extended GCD algorithm and Lehmer's algorithm.
+void benchmark_inverse()
+{
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 12;
+    for (const uint64_t n : {9223372036854775337UL, 9223372036854775336UL, 18446744073709551557UL, 18446744073709551556UL})
+    {
+        std::vector<uint64_t> a = random_residues(count, n, generator);
+        // Only odd elements are invertible modulo an even n.
+        for (uint64_t &value : a)
+        {
+            value |= n & 0x1 ? 0 : 1;
+        }
+
+        std::cout << "Speedup relative to the extended Euclidean algorithm, modulus " << n << ":" << std::endl;
+        double baseline = 0;
+        if (n <= static_cast<uint64_t>(INT64_MAX))
+        {
+            baseline = measure(count, [&](size_t i)
+                               {
+                                   int64_t tu1 = 0;
+                                   int64_t tu2 = 0;
+                                   extended_greatest_common_divisor(a[i], n, tu1, tu2);
+                                   return static_cast<uint64_t>(tu1); });
+            print_result("inverse", "extended Euclid", baseline, baseline);
+        }
+        else
+        {
+            // The extended Euclidean algorithm with int64_t does not work, so Lehmer's algorithm is the baseline.
+            baseline = measure(count, [&](size_t i) { return mod_inverse_lehmer(a[i], n).value_or(0); });
+        }
+        if (n == 9223372036854775337UL || n == 18446744073709551557UL)
+        {
+            print_result("inverse", "Fermat", measure(count, [&](size_t i) { return mod_multiplicative_inverse(a[i], n); }), baseline);
+        }
+        print_result("mod_inverse", "binary", measure(count, [&](size_t i) { return mod_inverse(a[i], n).value_or(0); }), baseline);
+        print_result("mod_inverse_lehmer", "Lehmer", measure(count, [&](size_t i) { return mod_inverse_lehmer(a[i], n).value_or(0); }), baseline);
+        std::cout << std::endl;
+    }
+}
+
+// Compares the batch functions in modular_arithmetic_batch.h for every supported instruction set to a loop over the scalar function.
+void benchmark_batch_add_subtract()
+{
+    const uint64_t n = 13686744073709492732UL;
+    std::mt19937_64 generator(42);
+    // The arrays fit into the L2 cache, otherwise all variants are limited by the memory bandwidth.
+    const size_t len = 1 << 12;
+    const size_t repetitions = 5000;
+    const std::vector<uint64_t> a = random_residues(len, n, generator);
+    const std::vector<uint64_t> b = random_residues(len, n, generator);
+    std::vector<uint64_t> out(len);
+
+    std::cout << "Speedup relative to the scalar loop, " << len << " elements:" << std::endl;
+
+    const double add_baseline = measure_batch(len, repetitions, [&]()
+                                              {
+                                                  for (size_t i = 0; i < len; i++)
+                                                  {
+                                                      out[i] = mod_add(a[i], b[i], n);
+                                                  }
+                                                  sink = out[len - 1]; });
+    print_result("mod_add", "scalar loop", add_baseline, add_baseline);
+    const double subtract_baseline = measure_batch(len, repetitions, [&]()
+                                                   {
+                                                       for (size_t i = 0; i < len; i++)
+                                                       {
+                                                           out[i] = mod_subtract(a[i], b[i], n);
+                                                       }
+                                                       sink = out[len - 1]; });
+    print_result("mod_subtract", "scalar loop", subtract_baseline, subtract_baseline);
+
+    const std::pair<BatchIsa, const char *> isas[] = {{BatchIsa::Scalar, "batch scalar"}, {BatchIsa::Avx2, "batch AVX2"}, {BatchIsa::Avx512, "batch AVX-512"}};
+    for (const auto &isa : isas)
+    {
+        if (isa.first > detect_batch_isa())
+        {
+            continue;
+        }
+        print_result("mod_add_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                { mod_add_batch(a.data(), b.data(), out.data(), len, n, isa.first); }),
+                     add_baseline);
+        print_result("mod_subtract_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                     { mod_subtract_batch(a.data(), b.data(), out.data(), len, n, isa.first); }),
+                     subtract_baseline);
+    }
+    std::cout << std::endl;
+}
+
+void print_throughput(const std::string &primitive, const std::string &implementation, double nanoseconds, double baseline)
+{
+    std::cout << std::left << std::setw(28) << primitive << std::setw(20) << implementation
+              << std::right << std::fixed << std::setprecision(1) << std::setw(12) << 1e3 / nanoseconds << " Melements/s"
+              << std::setprecision(2) << std::setw(10) << baseline / nanoseconds << "x" << std::endl;
+}
+
+// Compares the batch multiplications in modular_arithmetic_batch.h for every supported instruction set to a loop over mod_multiply.
+void benchmark_batch_multiply()
+{
+    const std::pair<BatchIsa, const char *> isas[] = {{BatchIsa::Scalar, "batch scalar"}, {BatchIsa::Avx2, "batch AVX2"}, {BatchIsa::Avx512, "batch AVX-512"}, {BatchIsa::Avx512Ifma, "batch AVX-512 IFMA"}};
+    // IFMA is only used for moduli below 2^52.
+    for (const uint64_t n : {18446744073709551557UL, 4503599627370449UL})
+    {
+        std::mt19937_64 generator(42);
+        const size_t len = 1 << 12;
+        const size_t repetitions = 2000;
+        const std::vector<uint64_t> a = random_residues(len, n, generator);
+        const std::vector<uint64_t> b = random_residues(len, n, generator);
+        const std::vector<uint64_t> c = random_residues(len, n, generator);
+        std::vector<uint64_t> out(len);
+
+        std::cout << "Throughput relative to the scalar loop, " << len << " elements, modulus " << n << ":" << std::endl;
+
+        const double multiply_baseline = measure_batch(len, repetitions, [&]()
+                                                       {
+                                                           for (size_t i = 0; i < len; i++)
+                                                           {
+                                                               out[i] = mod_multiply(a[i], b[i], n);
+                                                           }
+                                                           sink = out[len - 1]; });
+        print_throughput("mod_multiply", "scalar loop", multiply_baseline, multiply_baseline);
+        const double multiply_add_baseline = measure_batch(len, repetitions, [&]()
+                                                           {
+                                                               for (size_t i = 0; i < len; i++)
+                                                               {
+                                                                   out[i] = mod_add(mod_multiply(a[i], b[i], n), c[i], n);
+                                                               }
+                                                               sink = out[len - 1]; });
+        print_throughput("mod_multiply + mod_add", "scalar loop", multiply_add_baseline, multiply_add_baseline);
+
+        for (const auto &isa : isas)
+        {
+            if (isa.first > detect_batch_isa())
+            {
+                continue;
+            }
+            print_throughput("mod_multiply_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                             { mod_multiply_batch(a.data(), b.data(), out.data(), len, n, isa.first); }),
+                             multiply_baseline);
+            print_throughput("mod_sqr_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                        { mod_sqr_batch(a.data(), out.data(), len, n, isa.first); }),
+                             multiply_baseline);
+            print_throughput("mod_multiply_add_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                                 { mod_multiply_add_batch(a.data(), b.data(), c.data(), out.data(), len, n, isa.first); }),
+                             multiply_add_baseline);
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Compares mod_dot and mod_dot_batch to the loop with one mod_multiply and one mod_add per term, for moduli
+// which use the 32 bit lanes, IFMA, the blocked and the carry counting scalar loop.
+void benchmark_dot()
+{
+    const std::pair<BatchIsa, const char *> isas[] = {{BatchIsa::Avx2, "batch AVX2"}, {BatchIsa::Avx512, "batch AVX-512"}, {BatchIsa::Avx512Ifma, "batch AVX-512 IFMA"}};
+    for (const uint64_t n : {998244353UL, 4503599627370449UL, 18446744073709551557UL})
+    {
+        std::mt19937_64 generator(42);
+        const size_t len = 1 << 12;
+        const size_t repetitions = 2000;
+        const std::vector<uint64_t> a = random_residues(len, n, generator);
+        const std::vector<uint64_t> b = random_residues(len, n, generator);
+
+        std::cout << "Throughput of the dot product relative to the scalar loop, " << len << " elements, modulus " << n << ":" << std::endl;
+
+        const double baseline = measure_batch(len, repetitions, [&]()
+                                              {
+                                                  uint64_t sum = 0;
+                                                  for (size_t i = 0; i < len; i++)
+                                                  {
+                                                      sum = mod_add(sum, mod_multiply(a[i], b[i], n), n);
+                                                  }
+                                                  sink = sum; });
+        print_throughput("dot product", "scalar loop", baseline, baseline);
+        print_throughput("mod_dot", "lazy reduction", measure_batch(len, repetitions, [&]()
+                                                                   { sink = mod_dot(a.data(), b.data(), len, n); }),
+                         baseline);
+        for (const auto &isa : isas)
+        {
+            if (isa.first > detect_batch_isa())
+            {
+                continue;
+            }
+            print_throughput("mod_dot_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                        { sink = mod_dot_batch(a.data(), b.data(), len, n, isa.first); }),
+                             baseline);
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Compares the multiplication with a constant: mod_multiply, ShoupMultiplier and mod_multiply_constant_batch.
+void benchmark_shoup()
+{
+    const std::pair<BatchIsa, const char *> isas[] = {{BatchIsa::Scalar, "batch scalar"}, {BatchIsa::Avx2, "batch AVX2"}, {BatchIsa::Avx512, "batch AVX-512"}};
+    // The largest prime below 2^63.
+    const uint64_t n = 9223372036854775783UL;
+    std::mt19937_64 generator(42);
+    const size_t len = 1 << 12;
+    const size_t repetitions = 2000;
+    const std::vector<uint64_t> a = random_residues(len, n, generator);
+    const uint64_t w = generator() % n;
+    const ShoupMultiplier shoup(w, n);
+    std::vector<uint64_t> out(len);
+
+    std::cout << "Throughput of the multiplication with a constant relative to mod_multiply, " << len << " elements, modulus " << n << ":" << std::endl;
+
+    const double baseline = measure_batch(len, repetitions, [&]()
+                                          {
+                                              for (size_t i = 0; i < len; i++)
+                                              {
+                                                  out[i] = mod_multiply(a[i], w, n);
+                                              }
+                                              sink = out[len - 1]; });
+    print_throughput("mod_multiply", "scalar loop", baseline, baseline);
+    print_throughput("ShoupMultiplier::multiply", "scalar loop", measure_batch(len, repetitions, [&]()
+                                                                               {
+                                                                                   for (size_t i = 0; i < len; i++)
+                                                                                   {
+                                                                                       out[i] = shoup.multiply(a[i]);
+                                                                                   }
+                                                                                   sink = out[len - 1]; }),
+                     baseline);
+    for (const auto &isa : isas)
+    {
+        if (isa.first > detect_batch_isa())
+        {
+            continue;
+        }
+        print_throughput("mod_multiply_constant_batch", isa.second, measure_batch(len, repetitions, [&]()
+                                                                                  { mod_multiply_constant_batch(a.data(), out.data(), len, shoup, isa.first); }),
+                         baseline);
+    }
+    std::cout << std::endl;
+}
+
+// Compares poly_multiply to the schoolbook multiplication with mod_multiply for two polynomials with len coefficients.
+// The schoolbook multiplication is only measured up to 2^12 coefficients and extrapolated quadratically beyond.
+void benchmark_poly_multiply()
+{
+    const uint64_t p = ntt_prime_57;
+    std::mt19937_64 generator(42);
+    const NumberTheoreticTransform ntt(p, 1 << 21);
+    double schoolbook_per_term = 0;
+
+    std::cout << "Speedup of poly_multiply relative to the schoolbook multiplication, modulus " << p << ":" << std::endl;
+
+    for (size_t len = 1 << 8; len <= (1 << 20); len <<= 2)
+    {
+        const std::vector<uint64_t> a = random_residues(len, p, generator);
+        const std::vector<uint64_t> b = random_residues(len, p, generator);
+        const size_t repetitions = std::max<size_t>(1, (1 << 18) / len);
+        if (len <= (1 << 12))
+        {
+            std::vector<uint64_t> c(2 * len - 1);
+            const double nanoseconds = measure_batch(len * len, std::max<size_t>(1, (1 << 24) / (len * len)), [&]()
+                                                     {
+                                                         std::fill(c.begin(), c.end(), 0);
+                                                         for (size_t i = 0; i < len; i++)
+                                                         {
+                                                             for (size_t j = 0; j < len; j++)
+                                                             {
+                                                                 c[i + j] = mod_add(c[i + j], mod_multiply(a[i], b[j], p), p);
+                                                             }
+                                                         }
+                                                         sink = c[len]; });
+            schoolbook_per_term = nanoseconds;
+        }
+        const double schoolbook = schoolbook_per_term * len * len;
+        const double transform = measure_batch(1, repetitions, [&]()
+                                               { sink = ntt.multiply(a, b)[len]; });
+        std::cout << std::left << std::setw(28) << ("len = " + std::to_string(len)) << std::right << std::fixed << std::setprecision(3)
+                  << "schoolbook " << std::setw(12) << schoolbook / 1e6 << " ms" << (len > (1 << 12) ? " (extrapolated)" : "               ")
+                  << "  poly_multiply " << std::setw(9) << transform / 1e6 << " ms" << std::setprecision(1) << std::setw(12) << schoolbook / transform << "x" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Compares mod_matmul to the naive triple loop with mod_multiply and mod_add. The throughput is given in
+// GFLOP equivalents, one modular multiplication and one modular addition count as 2 operations.
+void benchmark_matmul()
+{
+    const uint64_t n = 18446744073709551557UL;
+    std::mt19937_64 generator(42);
+    ThreadPool pool;
+    double naive_per_product = 0;
+
+    std::cout << "Speedup of mod_matmul relative to the naive triple loop, modulus " << n << ", " << pool.size() << " threads:" << std::endl;
+
+    for (size_t size = 64; size <= 1024; size <<= 1)
+    {
+        const std::vector<uint64_t> a = random_residues(size * size, n, generator);
+        const std::vector<uint64_t> b = random_residues(size * size, n, generator);
+        std::vector<uint64_t> c(size * size);
+        const double products = static_cast<double>(size) * size * size;
+        if (size <= 256)
+        {
+            naive_per_product = measure_batch(size * size * size, std::max<size_t>(1, (1 << 24) / (size * size * size)), [&]()
+                                              {
+                                                  for (size_t i = 0; i < size; i++)
+                                                  {
+                                                      for (size_t j = 0; j < size; j++)
+                                                      {
+                                                          uint64_t sum = 0;
+                                                          for (size_t k = 0; k < size; k++)
+                                                          {
+                                                              sum = mod_add(sum, mod_multiply(a[i * size + k], b[k * size + j], n), n);
+                                                          }
+                                                          c[i * size + j] = sum;
+                                                      }
+                                                  }
+                                                  sink = c[size]; });
+        }
+        const double naive = naive_per_product * products;
+        const double tiled = measure_batch(1, std::max<size_t>(1, (1 << 26) / (size * size * size)), [&]()
+                                           {
+                                               mod_matmul(a.data(), b.data(), c.data(), size, size, size, n, pool);
+                                               sink = c[size]; });
+        std::cout << std::left << std::setw(28) << (std::to_string(size) + " x " + std::to_string(size)) << std::right << std::fixed << std::setprecision(3)
+                  << "naive " << std::setw(10) << naive / 1e6 << " ms" << (size > 256 ? " (extrapolated)" : "               ")
+                  << "  mod_matmul " << std::setw(9) << tiled / 1e6 << " ms " << std::setw(7) << 2 * products / tiled << " GFLOP/s"
+                  << std::setprecision(1) << std::setw(8) << naive / tiled << "x" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Compares mod_convolution for a modulus which is not NTT friendly with 1, 2 and 3 threads.
+void benchmark_convolution()
+{
+    const uint64_t n = 18446744073709551557UL;
+    std::mt19937_64 generator(42);
+    const size_t len = 1 << 19;
+    const std::vector<uint64_t> a = random_residues(len, n, generator);
+    const std::vector<uint64_t> b = random_residues(len, n, generator);
+
+    std::cout << "Speedup of mod_convolution relative to 1 thread, " << len << " coefficients, modulus " << n
+              << ", " << std::thread::hardware_concurrency() << " hardware threads:" << std::endl;
+
+    double baseline = 0;
+    for (size_t threads = 1; threads <= 3; threads++)
+    {
+        const double nanoseconds = measure_batch(1, 3, [&]()
+                                                 { sink = mod_convolution(a, b, n, threads)[len]; });
+        baseline = threads == 1 ? nanoseconds : baseline;
+        std::cout << std::left << std::setw(28) << "mod_convolution" << std::setw(20) << (std::to_string(threads) + " threads")
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(12) << nanoseconds / 1e6 << " ms"
+                  << std::setprecision(2) << std::setw(13) << baseline / nanoseconds << "x" << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+// Miller-Rabin test with the 7 bases of is_prime, but with mod_power instead of Montgomery multiplication and
+// without trial division.
+bool is_prime_mod_power(uint64_t n)
+{
+    if (n < 2 || (n & 0x1) == 0)
+    {
+        return n == 2;
+    }
+    uint64_t d = n - 1;
+    const int s = __builtin_ctzll(d);
+    d >>= s;
+    for (const uint64_t base : {2UL, 325UL, 9375UL, 28178UL, 450775UL, 9780504UL, 1795265022UL})
+    {
+        const uint64_t a = base % n;
+        if (a == 0)
+        {
+            continue;
+        }
+        uint64_t x = mod_power(a, d, n);
+        bool probable_prime = x == 1 || x == n - 1;
+        for (int r = 1; r < s && !probable_prime && x != 1; r++)
+        {
+            x = mod_sqr(x, n);
+            probable_prime = x == n - 1;
+        }
+        if (!probable_prime)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compares is_prime to the Miller-Rabin test with mod_power, for random odd numbers and for primes,
+// and is_prime_batch with 1 and all hardware threads.
+void benchmark_is_prime()
+{
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 16;
+    std::vector<uint64_t> odd(count);
+    std::vector<uint64_t> primes(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        odd[i] = generator() | 0x1;
+        primes[i] = next_prime(generator() >> 1).value();
+    }
+
+    std::cout << "Speedup of is_prime relative to Miller-Rabin with mod_power:" << std::endl;
+
+    for (const auto &candidates : {std::make_pair("is_prime, random odd", &odd), std::make_pair("is_prime, primes", &primes)})
+    {
+        const std::vector<uint64_t> &n = *candidates.second;
+        const double baseline = measure(count, [&](size_t i) { return is_prime_mod_power(n[i]); });
+        print_result(candidates.first, "mod_power", baseline, baseline);
+        print_result(candidates.first, "Montgomery", measure(count, [&](size_t i) { return is_prime(n[i]); }), baseline);
+    }
+    std::unique_ptr<bool[]> out(new bool[count]);
+    const double batch_baseline = measure_batch(count, 1, [&]()
+                                                { is_prime_batch(odd.data(), out.get(), count, 1); });
+    print_result("is_prime_batch", "1 thread", batch_baseline, batch_baseline);
+    const size_t threads = std::thread::hardware_concurrency();
+    print_result("is_prime_batch", std::to_string(threads) + " threads", measure_batch(count, 1, [&]()
+                                                                                      { is_prime_batch(odd.data(), out.get(), count); }),
+                 batch_baseline);
+    std::cout << std::endl;
+}
+
+// Pollard's rho algorithm with Floyd's cycle detection and one GCD per step.
+uint64_t pollard_rho_floyd(uint64_t n)
+{
+    for (uint64_t c = 1;; c++)
+    {
+        const auto step = [&](uint64_t x)
+        { return mod_add(mod_sqr(x, n), c % n, n); };
+        uint64_t x = 2 % n;
+        uint64_t y = x;
+        uint64_t g = 1;
+        while (g == 1)
+        {
+            x = step(x);
+            y = step(step(y));
+            g = std::gcd(x > y ? x - y : y - x, n);
+        }
+        if (g != n)
+        {
+            return g;
+        }
+    }
+}
+
+// Compares factorize to Pollard's rho algorithm with Floyd's cycle detection, for random numbers and
+// for products of two 32 bit primes.
+void benchmark_factorize()
+{
+    std::mt19937_64 generator(42);
+    const size_t count = 256;
+    std::vector<uint64_t> random(count);
+    std::vector<uint64_t> semiprimes(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        random[i] = generator() | 0x1;
+        const uint64_t p = next_prime((generator() >> 33) | (1UL << 31)).value();
+        const uint64_t q = next_prime((generator() >> 33) | (1UL << 31)).value();
+        semiprimes[i] = p * q;
+    }
+    const auto factorize_floyd = [](uint64_t n)
+    {
+        std::vector<uint64_t> factors;
+        std::vector<uint64_t> composites = {n};
+        while (!composites.empty())
+        {
+            const uint64_t m = composites.back();
+            composites.pop_back();
+            if (m == 1 || is_prime(m))
+            {
+                factors.push_back(m);
+                continue;
+            }
+            const uint64_t d = (m & 0x1) ? pollard_rho_floyd(m) : 2;
+            composites.push_back(d);
+            composites.push_back(m / d);
+        }
+        return factors.size();
+    };
+
+    std::cout << "Speedup of factorize relative to Pollard's rho algorithm with Floyd's cycle detection:" << std::endl;
+
+    for (const auto &numbers : {std::make_pair("factorize, random odd", &random), std::make_pair("factorize, 2 x 32 bit", &semiprimes)})
+    {
+        const std::vector<uint64_t> &n = *numbers.second;
+        const double baseline = measure(count, [&](size_t i) { return factorize_floyd(n[i]); });
+        print_result(numbers.first, "Floyd", baseline, baseline);
+        print_result(numbers.first, "Brent, batched GCD", measure(count, [&](size_t i) { return factorize(n[i]).size(); }), baseline);
+    }
+    std::cout << std::endl;
+}
+
+// Compares the Tonelli-Shanks and Cipolla algorithms to mod_sqrt and mod_sqrt_batch for primes with different
+// 2-adic valuations s of p - 1, and legendre_symbol to Euler's criterion with mod_power.
+void benchmark_mod_sqrt()
+{
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 14;
+
+    std::cout << "Speedup of the square roots relative to Tonelli-Shanks:" << std::endl;
+
+    for (const uint64_t p : {18446744073709551557UL, 998244353UL, ntt_prime_57})
+    {
+        const ModSqrtContext context(p);
+        std::vector<uint64_t> squares = random_residues(count, p, generator);
+        for (uint64_t &a : squares)
+        {
+            a = mod_sqr(a, p);
+            a = a == 0 ? 1 : a;
+        }
+        const std::string primitive = "s = " + std::to_string(__builtin_ctzll(p - 1)) + ", " + std::to_string(64 - __builtin_clzll(p)) + " bits";
+        const double baseline = measure(count, [&](size_t i) { return *context.tonelli_shanks(squares[i]); });
+        print_result(primitive, "Tonelli-Shanks", baseline, baseline);
+        print_result(primitive, "Cipolla", measure(count, [&](size_t i) { return *context.cipolla(squares[i]); }), baseline);
+        print_result(primitive, "mod_sqrt", measure(count, [&](size_t i) { return mod_sqrt(squares[i], p).value(); }), baseline);
+        std::vector<uint64_t> roots(count);
+        std::unique_ptr<bool[]> exists(new bool[count]);
+        print_result(primitive, "mod_sqrt_batch", measure_batch(count, 1, [&]()
+                                                                { mod_sqrt_batch(squares.data(), roots.data(), exists.get(), count, p); }),
+                     baseline);
+    }
+
+    const uint64_t p = 18446744073709551557UL;
+    const std::vector<uint64_t> a = random_residues(count, p, generator);
+    const double baseline = measure(count, [&](size_t i) { return mod_power(a[i], p >> 1, p); });
+    print_result("legendre_symbol", "mod_power", baseline, baseline);
+    print_result("legendre_symbol", "Jacobi", measure(count, [&](size_t i) { return static_cast<uint64_t>(legendre_symbol(a[i], p)); }), baseline);
+    std::cout << std::endl;
+}
+
+// Compares BabyStepGiantStep with different memory budgets and discrete_log ("PH", Pohlig-Hellman) with 1 and all
+// hardware threads to the linear scan a^0, a^1, ..., whose time is extrapolated from 2^20 steps to the average of
+// order / 2 steps. For 64 bit primes, the linear scan and BSGS with the full order are out of reach, so discrete_log
+// with 1 thread is the baseline.
+void benchmark_discrete_log()
+{
+    std::mt19937_64 generator(42);
+    const size_t count = 8;
+    const size_t threads = std::thread::hardware_concurrency();
+
+    std::cout << "Speedup of the discrete logarithm relative to the linear scan:" << std::endl;
+
+    const auto print_line = [](const std::string &primitive, const std::string &implementation, double nanoseconds, double baseline)
+    {
+        std::cout << std::left << std::setw(28) << primitive << std::setw(20) << implementation
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(12) << nanoseconds / 1e6 << " ms"
+                  << std::setprecision(1) << std::setw(13) << baseline / nanoseconds << "x" << std::endl;
+    };
+
+    // p - 1 = 2 * 500000003, p - 1 = 2^23 * 7 * 17, p - 1 = 2^2 * 43 * 67 * 193 * 809383 * 10247197 and p - 1 = 29 * 2^57.
+    for (const uint64_t p : {1000000007UL, 998244353UL, 18446744073709551533UL, ntt_prime_57})
+    {
+        uint64_t a = 2;
+        while (multiplicative_order(a, p).value() != p - 1)
+        {
+            a++;
+        }
+        std::vector<uint64_t> b(count);
+        for (uint64_t &y : b)
+        {
+            y = mod_power(a, generator() % (p - 1), p);
+        }
+        const std::string primitive = "p = " + std::to_string(p);
+        const auto discrete_log_time = [&](size_t t)
+        {
+            return measure_batch(count, 1, [&]()
+                                 {
+                                     for (const uint64_t y : b)
+                                     {
+                                         sink = discrete_log(a, y, p, discrete_log_memory_budget, t).value();
+                                     } });
+        };
+
+        if (p >= (1UL << 32))
+        {
+            const double baseline = discrete_log_time(1);
+            print_line(primitive, "PH 1 thread", baseline, baseline);
+            print_line(primitive, "PH " + std::to_string(threads) + " threads", discrete_log_time(threads), baseline);
+            continue;
+        }
+
+        const size_t scan_steps = 1 << 20;
+        const double baseline = measure_batch(scan_steps, 1, [&]()
+                                              {
+                                                  uint64_t y = 1;
+                                                  for (size_t x = 0; x < scan_steps && y != 0; x++)
+                                                  {
+                                                      y = mod_multiply(y, a, p);
+                                                  }
+                                                  sink = y; }) *
+                                static_cast<double>(p / 2);
+        print_line(primitive, "linear scan", baseline, baseline);
+        for (const size_t memory_budget : {discrete_log_memory_budget, static_cast<size_t>(1 << 16)})
+        {
+            const BabyStepGiantStep solver(a, p, p - 1, memory_budget);
+            const double nanoseconds = measure_batch(count, 1, [&]()
+                                                     {
+                                                         for (const uint64_t y : b)
+                                                         {
+                                                             sink = solver.log(y).value();
+                                                         } });
+            print_line(primitive, "BSGS " + std::to_string(memory_budget >> 10) + " KiB", nanoseconds, baseline);
+        }
+        print_line(primitive, "PH 1 thread", discrete_log_time(1), baseline);
+        print_line(primitive, "PH " + std::to_string(threads) + " threads", discrete_log_time(threads), baseline);
+    }
+    std::cout << std::endl;
+}
+
+// Compares the lookup of C(n, k) % p in a BinomialTable to the computation from scratch with k multiplications
+// and one mod_multiplicative_inverse, and the construction of the table with 1 and all hardware threads to
+// mapping a saved table from disk.
+void benchmark_binomial()
+{
+    const uint64_t p = 1000000007;
+    const uint64_t max_n = 1 << 24;
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 16;
+    std::vector<uint64_t> n(count);
+    std::vector<uint64_t> k(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        n[i] = generator() % max_n;
+        k[i] = generator() % (n[i] + 1);
+    }
+
+    std::cout << "Speedup of C(n, k) % " << p << " with a BinomialTable relative to the computation from scratch, n < " << max_n << ":" << std::endl;
+
+    const BinomialTable table = BinomialTable::create(p, max_n).value();
+    const double baseline = measure(64, [&](size_t i)
+                                    {
+                                        uint64_t numerator = 1;
+                                        uint64_t denominator = 1;
+                                        for (uint64_t j = 0; j < k[i]; j++)
+                                        {
+                                            numerator = mod_multiply(numerator, n[i] - j, p);
+                                            denominator = mod_multiply(denominator, j + 1, p);
+                                        }
+                                        return mod_multiply(numerator, mod_multiplicative_inverse(denominator, p), p); });
+    print_result("binomial", "from scratch", baseline, baseline);
+    print_result("binomial", "BinomialTable", measure(count, [&](size_t i) { return *table.binomial(n[i], k[i]); }), baseline);
+
+    const auto print_line = [](const std::string &implementation, double nanoseconds, double baseline)
+    {
+        std::cout << std::left << std::setw(28) << "BinomialTable startup" << std::setw(20) << implementation
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(12) << nanoseconds / 1e6 << " ms"
+                  << std::setprecision(1) << std::setw(13) << baseline / nanoseconds << "x" << std::endl;
+    };
+    const size_t threads = std::thread::hardware_concurrency();
+    const double build_baseline = measure_batch(1, 1, [&]()
+                                                { sink = BinomialTable::create(p, max_n, 1)->factorial(max_n); });
+    print_line("build, 1 thread", build_baseline, build_baseline);
+    print_line("build, " + std::to_string(threads) + " threads", measure_batch(1, 1, [&]()
+                                                                             { sink = BinomialTable::create(p, max_n, threads)->factorial(max_n); }),
+               build_baseline);
+#if defined(BINOMIAL_TABLE_MMAP)
+    const std::string path = (std::filesystem::temp_directory_path() / "modular_arithmetic_benchmark_binomial.bin").string();
+    if (table.save(path))
+    {
+        print_line("map_file", measure_batch(1, 1, [&]()
+                                             { sink = BinomialTable::map_file(path)->factorial(max_n); }),
+                   build_baseline);
+        std::remove(path.c_str());
+    }
+#endif
+    std::cout << std::endl;
+}
+
+// Compares the hashing with RollingHash to a loop with one mod_multiply and one mod_add per byte.
+void benchmark_rolling_hash()
+{
+    const size_t len = 1 << 24;
+    const size_t window = 64;
+    std::mt19937_64 generator(42);
+    std::vector<uint8_t> data(len);
+    for (uint8_t &c : data)
+    {
+        c = static_cast<uint8_t>(generator());
+    }
+    const RollingHash<> hasher(window);
+    const DoubleRollingHash<> double_hasher(window);
+    const uint64_t n = MersenneModulus<61>::modulus;
+
+    std::cout << "Throughput of the rolling hash relative to mod_multiply and mod_add per byte, " << len << " bytes, modulus " << n << ":" << std::endl;
+
+    const double baseline = measure_batch(len, 1, [&]()
+                                          {
+                                              uint64_t hash = 0;
+                                              for (size_t i = 0; i < len; i++)
+                                              {
+                                                  hash = mod_add(mod_multiply(hash, hasher.base(), n), data[i], n);
+                                              }
+                                              sink = hash; });
+    print_throughput("hash", "mod_multiply loop", baseline, baseline);
+    print_throughput("hash", "bytewise append", measure_batch(len, 1, [&]()
+                                                              {
+                                                                  uint64_t hash = 0;
+                                                                  for (size_t i = 0; i < len; i++)
+                                                                  {
+                                                                      hash = hasher.append(hash, data[i]);
+                                                                  }
+                                                                  sink = hash; }),
+                     baseline);
+    print_throughput("hash", "block append", measure_batch(len, 4, [&]()
+                                                           { sink = hasher.hash(data.data(), len); }),
+                     baseline);
+    print_throughput("hash", "two moduli", measure_batch(len, 4, [&]()
+                                                         { sink = double_hasher.hash(data.data(), len).second; }),
+                     baseline);
+    std::vector<uint64_t> hashes(len - window + 1);
+    print_throughput("window_hashes", "64 bytes", measure_batch(len, 1, [&]()
+                                                                {
+                                                                    hasher.window_hashes(data.data(), len, hashes.data());
+                                                                    sink = hashes.back(); }),
+                     baseline);
+    const std::string path = (std::filesystem::temp_directory_path() / "modular_arithmetic_benchmark_rolling_hash.bin").string();
+    if (std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(data.data()), len))
+    {
+        print_throughput("hash_file", "page cache", measure_batch(len, 4, [&]()
+                                                                  { sink = *hash_file(hasher, path); }),
+                         baseline);
+        std::remove(path.c_str());
+    }
+    std::cout << std::endl;
+}
+
+// Compares the multi-precision multiplications of multi_precision.h for Bits bit numbers:
+// Karatsuba against schoolbook multiplication, and Montgomery multiplication against mod_multiply.
+template <size_t Bits>
+void benchmark_multi_precision()
+{
+    std::mt19937_64 generator(42);
+    const size_t count = 1 << 10;
+    UInt<Bits> n;
+    for (uint64_t &limb : n.limbs)
+    {
+        limb = generator();
+    }
+    n.limbs[0] |= 0x1;
+    n.limbs[UInt<Bits>::limb_count - 1] |= 1UL << 63;
+    std::vector<UInt<Bits>> a(count);
+    std::vector<UInt<Bits>> b(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t l = 0; l < UInt<Bits>::limb_count; l++)
+        {
+            a[i].limbs[l] = generator();
+            b[i].limbs[l] = generator();
+        }
+        a[i].limbs[UInt<Bits>::limb_count - 1] >>= 1;
+        b[i].limbs[UInt<Bits>::limb_count - 1] >>= 1;
+    }
+    const UIntMontgomeryContext<Bits> montgomery(n);
+
+    std::cout << "Speedup of the " << Bits << " bit multiplications:" << std::endl;
+
+    const std::string bits = std::to_string(Bits) + " bit";
+    const double baseline = measure(count, [&](size_t i) { return multiply_schoolbook(a[i], b[i]).limbs[UInt<Bits>::limb_count]; });
+    print_result("multiply, " + bits, "schoolbook", baseline, baseline);
+    print_result("multiply, " + bits, "Karatsuba", measure(count, [&](size_t i) { return multiply_karatsuba(a[i], b[i]).limbs[UInt<Bits>::limb_count]; }), baseline);
+    const double modular_baseline = measure(count, [&](size_t i) { return mod_multiply_double_and_add(a[i], b[i], n).limbs[0]; });
+    print_result("mod_multiply, " + bits, "double and add", modular_baseline, modular_baseline);
+    print_result("mod_multiply, " + bits, "mod_multiply", measure(count, [&](size_t i) { return mod_multiply(a[i], b[i], n).limbs[0]; }), modular_baseline);
+    print_result("mod_multiply, " + bits, "Montgomery", measure(count, [&](size_t i) { return montgomery.multiply(a[i], b[i]).limbs[0]; }), modular_baseline);
+    // Square and multiply with mod_multiply, as mod_power does for even moduli.
+    const auto power_double_and_add = [&](const UInt<Bits> &x, const UInt<Bits> &e)
+    {
+        UInt<Bits> y = 1;
+        for (size_t i = e.bit_width(); i-- > 0;)
+        {
+            y = mod_multiply_double_and_add(y, y, n);
+            y = e.bit(i) ? mod_multiply_double_and_add(y, x, n) : y;
+        }
+        return y;
+    };
+    const size_t power_count = count / UInt<Bits>::limb_count / 64;
+    const double power_baseline = measure(power_count, [&](size_t i) { return power_double_and_add(a[i], b[i]).limbs[0]; });
+    print_result("mod_power, " + bits, "double and add", power_baseline, power_baseline);
+    print_result("mod_power, " + bits, "Montgomery", measure(power_count, [&](size_t i) { return mod_power(a[i], b[i], n).limbs[0]; }), power_baseline);
+    std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    benchmark_multiply_kernels();
+    benchmark_special_modulus<MersenneModulus<61>>("Mersenne");
+    benchmark_special_modulus<PseudoMersenneModulus<59>>("pseudo-Mersenne");
+    benchmark_special_modulus<SolinasModulus<32>>("Solinas");
+    benchmark_sliding_window();
+    benchmark_fixed_base();
+    benchmark_multi_power();
+    benchmark_inverse();
+    benchmark_inverse_batch();
+    benchmark_batch_add_subtract();
+    benchmark_batch_multiply();
+    benchmark_dot();
+    benchmark_shoup();
+    benchmark_poly_multiply();
+    benchmark_matmul();
+    benchmark_convolution();
+    benchmark_is_prime();
+    benchmark_factorize();
+    benchmark_mod_sqrt();
+    benchmark_discrete_log();
+    benchmark_binomial();
+    benchmark_rolling_hash();
+    benchmark_multi_precision<256>();
+    benchmark_multi_precision<1024>();
+    return 0;
+}
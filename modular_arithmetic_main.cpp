@@ -1,221 +1,27 @@
+#include <array>
 #include <iostream>
+#include <vector>
 #include <assert.h>
 
-// This code shows how to do modular arithmetic in C++ (https://en.wikipedia.org/wiki/Modular_arithmetic).
-
-// In the following, we assume that the input to the functions is valid, meaning is an element of Z_n.
-// Therefore, the modulo operator is the special case of the euclidean reminder for values where a >= 0 and b > 0.
-// This allows us to use just the modulo operator "%" to perform the modulo operation.
-
-// This function computes the euclidean reminder for values where n > 0.
-// It allows to convert any value (even negative) into the space Z_n.
-inline uint64_t mod(int64_t a, int64_t n)
-{
-    assert(n > 0);
-    return ((a % n) + n) % n;
-}
-
-// This function computes the euclidean reminder for values where n > 0 and a > 0.
-// It allows to convert positive values into the space Z_n.
-inline uint64_t mod_pos(uint64_t a, uint64_t n)
-{
-    assert(n > 0);
-    return a % n;
-}
-
-// This function computes (a + b) % n.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-inline uint64_t mod_add(uint64_t a, uint64_t b, uint64_t n)
-{
-    assert(a < n);
-    assert(b < n);
-    assert(n > 0);
-
-    if (b == 0)
-        return a;
-
-    // Returns mod_minus(a, m-b, m);
-    b = n - b;
-    if (a >= b)
-        return a - b;
-    else
-        return n - b + a;
-}
-
-// This function computes (a - b) % n.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-inline uint64_t mod_subtract(uint64_t a, uint64_t b, uint64_t n)
-{
-    assert(a < n);
-    assert(b < n);
-    assert(n > 0);
-
-    if (a >= b)
-    {
-        return a - b;
-    }
-    else
-    {
-        return n - b + a;
-    }
-}
-
-// This function computes (a + 1) % n.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-inline uint64_t mod_increment(uint64_t a, uint64_t n)
-{
-    assert(a < n);
-    assert(n > 0);
-
-    a++;
-    if (a == n)
-    {
-        a = 0;
-    }
-    return a;
-}
-
-// This function computes (a - 1) % n.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-inline uint64_t mod_decrement(uint64_t a, uint64_t n)
-{
-    assert(a < n);
-    assert(n > 0);
-
-    if (a == 0)
-    {
-        a = n - 1;
-    }
-    else
-    {
-        a--;
-    }
-    return a;
-}
-
-// This function computes the additive inverse of a, such that:
-// mod_add(a, mod_additive_inverse(a, n), n) == 0.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-inline uint64_t mod_additive_inverse(uint64_t a, uint64_t n)
-{
-    assert(a < n);
-    assert(n > 0);
-
-    if (a == 0)
-    {
-        return 0;
-    }
-    else
-    {
-        return n - a;
-    }
-}
-
-// This function computes (a * b) % n.
-// It uses the double and add algorithm to achieve this, requires O(log(a) + log(b)) time.
-inline uint64_t mod_multiply(uint64_t a, uint64_t b, uint64_t n)
-{
-    assert(a < n);
-    assert(b < n);
-    assert(n > 0);
-
-    uint64_t product = 0;
-    if (b > a)
-    {
-        std::swap(a, b);
-    }
-
-    while (b)
-    {
-        if (b & 0x1)
-        {
-            product = mod_add(product, a, n);
-        }
-        a = mod_add(a, a, n);
-        b >>= 1;
-    }
-    return product;
-}
-
-// This function computes (a * a) % n.
-inline uint64_t mod_sqr(uint64_t a, uint64_t n)
-{
-    assert(a < n);
-    assert(n > 0);
-    return mod_multiply(a, a, n);
-}
-
-// This function computes (a^e) % n.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-inline uint64_t mod_power(uint64_t a, uint64_t e, uint64_t n)
-{
-    assert(a < n);
-    assert(n > 0);
-
-    if (e == 0)
-    {
-        return 1;
-    }
-    else
-    {
-        uint64_t z = a;
-        uint64_t y = 1;
-        while (1)
-        {
-            if (e & 0x1)
-            {
-                y = mod_multiply(y, z, n); // y *= z;
-            }
-            e >>= 1;
-            if (0 == e)
-            {
-                break;
-            }
-            z = mod_sqr(z, n); // z *= z;
-        }
-        return y;
-    }
-}
+#include "modular_arithmetic.h"
+#include "modular_arithmetic_batch.h"
+#include "number_theory.h"
 
-// Returns the multiplicative inverse of a, such that:
-// mod_multiply(a, mod_multiplicative_inverse(a, n)) == 1.
-// Note that the multiplicative inverse only exists when n is a prime.
-inline uint64_t mod_multiplicative_inverse(uint64_t a, uint64_t n)
-{
-    assert(a < n);
-    assert(n > 0);
-    return mod_power(a, n - 2, n);
-}
+// This code shows how to do modular arithmetic in C++ (https://en.wikipedia.org/wiki/Modular_arithmetic).
+// The functions are implemented in modular_arithmetic.h.
 
-// This function returns u3 and sets tu1, tu2 such that that gcd(a,n) == u3 == a*tu1 + n*tu2.
-// This can be used to determine the multiplicative inverse:
-// To invert a % n, we need gcd(a, n) = 1.
-// We can call the extended GCD algorithm with a and n as input and check if the GCD is 1.
-// If so, we also get tu1, tu2 such that a*tu1 + n*tu2 = u3 = 1. We then see that:
-// (a*tu1 + n*tu2) % n = a*tu1 % n = 1. Therefore, tu1 is the inverse of a.
-// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapter 39.1.
-uint64_t extended_greatest_common_divisor(int64_t a, int64_t n, int64_t &tu1, int64_t &tu2)
+// The powers 3^0, ..., 3^7 modulo 9223372036854775337, computed at compile time.
+constexpr std::array<ModInt<9223372036854775337UL>, 8> powers_of_three = []
 {
-    int64_t u1 = 1, u2 = 0;
-    int64_t v1 = 0, v3 = n;
-    int64_t u3 = a, v2 = 1;
-    while (v3 != 0)
+    std::array<ModInt<9223372036854775337UL>, 8> powers{};
+    powers[0] = 1;
+    for (size_t i = 1; i < powers.size(); i++)
     {
-        int64_t q = u3 / v3;
-        int64_t t1 = u1 - v1 * q;
-        u1 = v1;
-        v1 = t1;
-        int64_t t3 = u3 - v3 * q;
-        u3 = v3;
-        v3 = t3;
-        int64_t t2 = u2 - v2 * q;
-        u2 = v2;
-        v2 = t2;
+        powers[i] = powers[i - 1] * 3;
     }
-    tu1 = u1;
-    tu2 = u2;
-    return u3;
-}
+    return powers;
+}();
+static_assert(powers_of_three[7].value() == 2187);
 
 int main(int argc, char **argv)
 {
@@ -230,6 +36,34 @@ int main(int argc, char **argv)
     std::cout << "(18446743983658366132 * 17446663900858366132) % 18446743988858366132 = " << mod_multiply(18446743983658366132UL, 17446663900858366132UL, 18446743988858366132UL) << std::endl;
     std::cout << "(9876743983658366132 * 9876743983658366132) % 18446743988858366132 = " << mod_sqr(9876743983658366132UL, 18446743988858366132UL) << std::endl;
     std::cout << "(7829454892340959985^437827489237484) % 12985254587577588852 = " << mod_power(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL) << std::endl;
+    std::cout << "Sliding window: (7829454892340959985^437827489237484) % 12985254587577588852 = " << mod_power_sliding_window(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL) << std::endl;
+    assert(mod_power_sliding_window(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL) == mod_power(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL));
+    const FixedBasePower<> fixed_base(7829454892340959985UL, 12985254587577588852UL);
+    std::cout << "Fixed base: (7829454892340959985^437827489237484) % 12985254587577588852 = " << fixed_base.power(437827489237484UL) << std::endl;
+    assert(fixed_base.power(437827489237484UL) == mod_power(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL));
+    const uint64_t multi_power_bases[] = {7829454892340959985UL, 3577888489959895UL, 97845874148483UL};
+    const uint64_t multi_power_exponents[] = {437827489237484UL, 68529989UL, 9223372036854775335UL};
+    const uint64_t multi_power = mod_multi_power(multi_power_bases, multi_power_exponents, 3, 12985254587577588852UL);
+    std::cout << "Multi power: (7829454892340959985^437827489237484 * 3577888489959895^68529989 * 97845874148483^9223372036854775335) % 12985254587577588852 = " << multi_power << std::endl;
+    assert(multi_power == mod_multiply(mod_multiply(mod_power(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL), mod_power(3577888489959895UL, 68529989UL, 12985254587577588852UL), 12985254587577588852UL), mod_power(97845874148483UL, 9223372036854775335UL, 12985254587577588852UL), 12985254587577588852UL));
+    const uint64_t inverse_in[] = {97845874148483UL, 0, 978458741484UL, 7829454892340959985UL, 1};
+    uint64_t inverse_out[5];
+    const size_t non_invertible = mod_inverse_batch(inverse_in, inverse_out, 5, 9223372036854775337UL);
+    std::cout << "Batch inverse: (97845874148483 * x) % 9223372036854775337 = 1 -> x = " << inverse_out[0] << ", non-invertible elements: " << non_invertible << std::endl;
+    assert(non_invertible == 1 && inverse_out[1] == 0);
+    for (size_t i : {0, 2, 3, 4})
+    {
+        assert(inverse_out[i] == mod_multiplicative_inverse(inverse_in[i], 9223372036854775337UL));
+    }
+    // Both numbers are even, so there is no inverse.
+    assert(!mod_inverse(978458741484, 92233720368547754UL));
+    std::cout << "mod_inverse: (978458741484 * x) % 92233720368547754 = 1 -> not invertible" << std::endl;
+    std::cout << "mod_inverse: (97845874148483 * x) % 18446744073709551556 = 1 -> x = " << mod_inverse(97845874148483UL, 18446744073709551556UL).value() << std::endl;
+    assert(mod_multiply(97845874148483UL, mod_inverse(97845874148483UL, 18446744073709551556UL).value(), 18446744073709551556UL) == 1);
+    assert(mod_inverse_lehmer(97845874148483UL, 18446744073709551556UL) == mod_inverse(97845874148483UL, 18446744073709551556UL));
+    assert(mod_inverse(97845874148483UL, 9223372036854775337UL) == mod_multiplicative_inverse(97845874148483UL, 9223372036854775337UL));
+    // mod_multiplicative_inverse requires a prime modulus.
+    assert(is_prime(9223372036854775337UL) && is_prime(92233720368547753UL));
     std::cout << "(97845874148483 * x) % 9223372036854775337 = 1 -> x = " << mod_multiplicative_inverse(97845874148483UL, 9223372036854775337UL) << std::endl;
     std::cout << "(97845874148483 * 7706179975126099074) % 9223372036854775337 = " << mod_multiply(97845874148483, mod_multiplicative_inverse(97845874148483UL, 9223372036854775337UL), 9223372036854775337UL) << std::endl;
     std::cout << "(978458741484 * 18798863501111358) % 92233720368547753 = " << mod_multiply(978458741484, mod_multiplicative_inverse(978458741484, 92233720368547753UL), 92233720368547753UL) << std::endl;
@@ -239,4 +73,179 @@ int main(int argc, char **argv)
     uint64_t u3 = extended_greatest_common_divisor(978458741484, 92233720368547753, tu1, tu2);
     assert(u3 == 1);
     std::cout << "(978458741484 * " << tu1 << " + 92233720368547753 * " << tu2 << ") % 92233720368547753 = " << mod_add(mod_multiply(978458741484, tu1, 92233720368547753), 0, 92233720368547753) << std::endl;
+
+    MontgomeryContext montgomery(9223372036854775337UL);
+    const uint64_t a_montgomery = montgomery.to_montgomery(7829454892340959985UL);
+    const uint64_t b_montgomery = montgomery.to_montgomery(97845874148483UL);
+    std::cout << "Montgomery: (7829454892340959985 * 97845874148483) % 9223372036854775337 = " << montgomery.from_montgomery(montgomery.multiply(a_montgomery, b_montgomery)) << std::endl;
+    assert(montgomery.from_montgomery(montgomery.multiply(a_montgomery, b_montgomery)) == mod_multiply(7829454892340959985UL, 97845874148483UL, 9223372036854775337UL));
+    std::cout << "Montgomery: (7829454892340959985^437827489237484) % 9223372036854775337 = " << montgomery.from_montgomery(montgomery.power(a_montgomery, 437827489237484UL)) << std::endl;
+    assert(montgomery.from_montgomery(montgomery.power(a_montgomery, 437827489237484UL)) == mod_power(7829454892340959985UL, 437827489237484UL, 9223372036854775337UL));
+
+    MontgomeryContext montgomery_large(18446744073709551557UL);
+    const uint64_t c_montgomery = montgomery_large.to_montgomery(18446744073709551556UL);
+    std::cout << "Montgomery: (18446744073709551556^2) % 18446744073709551557 = " << montgomery_large.from_montgomery(montgomery_large.square(c_montgomery)) << std::endl;
+    assert(montgomery_large.from_montgomery(montgomery_large.square(c_montgomery)) == mod_sqr(18446744073709551556UL, 18446744073709551557UL));
+
+    BarrettReducer barrett(12985254587577588852UL);
+    std::cout << "Barrett: 368554407370949273 % 698223547 = " << BarrettReducer(698223547).reduce(368554407370949273UL) << std::endl;
+    assert(BarrettReducer(698223547).reduce(368554407370949273UL) == mod_pos(368554407370949273UL, 698223547));
+    std::cout << "Barrett: (7829454892340959985 * 437827489237484) % 12985254587577588852 = " << barrett.multiply(7829454892340959985UL, 437827489237484UL) << std::endl;
+    assert(barrett.multiply(7829454892340959985UL, 437827489237484UL) == mod_multiply(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL));
+    std::cout << "Barrett: (7829454892340959985^437827489237484) % 12985254587577588852 = " << barrett.power(7829454892340959985UL, 437827489237484UL) << std::endl;
+    assert(barrett.power(7829454892340959985UL, 437827489237484UL) == mod_power(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL));
+
+    constexpr ModInt<9223372036854775337UL> prime_a = 97845874148483UL;
+    static_assert((prime_a * prime_a.inverse()).value() == 1);
+    static_assert(prime_a.inverse().value() == mod_multiplicative_inverse(97845874148483UL, 9223372036854775337UL));
+    std::cout << "ModInt: (97845874148483 * x) % 9223372036854775337 = 1 -> x = " << prime_a.inverse().value() << std::endl;
+    std::cout << "ModInt: 3^7 % 9223372036854775337 = " << powers_of_three[7].value() << std::endl;
+
+    constexpr ModInt<12985254587577588852UL> even_a = 7829454892340959985UL;
+    static_assert(even_a.pow(437827489237484UL).value() == mod_power(7829454892340959985UL, 437827489237484UL, 12985254587577588852UL));
+    std::cout << "ModInt: (7829454892340959985^437827489237484) % 12985254587577588852 = " << even_a.pow(437827489237484UL).value() << std::endl;
+    std::cout << "ModInt: (3577888489959895 - 1944674407370949273) % 13686744073709492732 = " << (ModInt<13686744073709492732UL>(3577888489959895UL) - 1944674407370949273UL).value() << std::endl;
+
+    // Special-form moduli: 2^61 - 1, 2^64 - 59 and 2^64 - 2^32 + 1 give the same results as the generic functions.
+    using Mersenne61 = MersenneModulus<61>;
+    using PseudoMersenne59 = PseudoMersenneModulus<59>;
+    using Solinas32 = SolinasModulus<32>;
+    static_assert(mod_power<Mersenne61>(3, Mersenne61::modulus - 1) == 1);
+    static_assert(ModInt<Mersenne61::modulus>(2).pow(61) == 1);
+    std::cout << "Mersenne: (7829454892340959985 * 97845874148483) % (2^61 - 1) = " << mod_multiply<Mersenne61>(7829454892340959985UL % Mersenne61::modulus, 97845874148483UL) << std::endl;
+    std::cout << "Pseudo-Mersenne: 3^437827489237484 % (2^64 - 59) = " << mod_power<PseudoMersenne59>(3, 437827489237484UL) << std::endl;
+    std::cout << "Solinas: 7^(2^32) % (2^64 - 2^32 + 1) = " << mod_power<Solinas32>(7, 1UL << 32) << std::endl;
+    const auto check_special_modulus = [](auto modulus_policy)
+    {
+        using Modulus = decltype(modulus_policy);
+        const uint64_t n = Modulus::modulus;
+        for (uint64_t i = 0; i < 1000; i++)
+        {
+            const uint64_t a = n - 1 - i * 7919;
+            const uint64_t b = (i * 0x9e3779b97f4a7c15UL) % n;
+            const unsigned __int128 x = (static_cast<unsigned __int128>(~(i * i)) << 64) | (a ^ b);
+            assert(mod_multiply<Modulus>(a, b) == mod_multiply(a, b, n));
+            assert(mod_reduce<Modulus>(x) == static_cast<uint64_t>(x % n));
+            assert(mod_power<Modulus>(a, b) == mod_power(a, b, n));
+        }
+    };
+    check_special_modulus(Mersenne61());
+    check_special_modulus(MersenneModulus<31>());
+    check_special_modulus(PseudoMersenne59());
+    check_special_modulus(PseudoMersenneModulus<4294967295UL>());
+    check_special_modulus(Solinas32());
+    check_special_modulus(SolinasModulus<7>());
+
+    // The batch functions give the same results as the scalar functions for every supported instruction set.
+    const uint64_t batch_n = 13686744073709492732UL;
+    const std::vector<uint64_t> batch_a = {0, 1, 3577888489959895UL, 13686744073709492731UL, 6843372036854746366UL, 0, 1944674407370949273UL, 13686744073709492730UL, 42, 7};
+    const std::vector<uint64_t> batch_b = {0, 13686744073709492731UL, 1944674407370949273UL, 13686744073709492731UL, 6843372036854746366UL, 5, 3577888489959895UL, 1, 0, 13686744073709492700UL};
+    std::vector<uint64_t> batch_out(batch_a.size());
+    for (BatchIsa isa : {BatchIsa::Scalar, BatchIsa::Avx2, BatchIsa::Avx512, BatchIsa::Avx512Ifma})
+    {
+        if (isa > detect_batch_isa())
+        {
+            continue;
+        }
+        mod_add_batch(batch_a.data(), batch_b.data(), batch_out.data(), batch_a.size(), batch_n, isa);
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            assert(batch_out[i] == mod_add(batch_a[i], batch_b[i], batch_n));
+        }
+        mod_subtract_batch(batch_a.data(), batch_b.data(), batch_out.data(), batch_a.size(), batch_n, isa);
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            assert(batch_out[i] == mod_subtract(batch_a[i], batch_b[i], batch_n));
+        }
+        mod_additive_inverse_batch(batch_a.data(), batch_out.data(), batch_a.size(), batch_n, isa);
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            assert(batch_out[i] == mod_additive_inverse(batch_a[i], batch_n));
+        }
+        mod_increment_batch(batch_a.data(), batch_out.data(), batch_a.size(), batch_n, isa);
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            assert(batch_out[i] == mod_increment(batch_a[i], batch_n));
+        }
+        mod_decrement_batch(batch_a.data(), batch_out.data(), batch_a.size(), batch_n, isa);
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            assert(batch_out[i] == mod_decrement(batch_a[i], batch_n));
+        }
+    }
+    mod_add_batch(batch_a.data(), batch_b.data(), batch_out.data(), batch_a.size(), batch_n);
+    std::cout << "Batch: (3577888489959895 + 1944674407370949273) % 13686744073709492732 = " << batch_out[2] << std::endl;
+
+    // The batch multiplications need an odd modulus for the vectorized Montgomery multiplication, and one below 2^52 for IFMA.
+    for (uint64_t multiply_n : {9223372036854775337UL, 4503599627370449UL})
+    {
+        std::vector<uint64_t> multiply_a(batch_a.size());
+        std::vector<uint64_t> multiply_b(batch_b.size());
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            multiply_a[i] = mod_pos(batch_a[i], multiply_n);
+            multiply_b[i] = mod_pos(batch_b[i], multiply_n);
+        }
+        for (BatchIsa isa : {BatchIsa::Scalar, BatchIsa::Avx2, BatchIsa::Avx512, BatchIsa::Avx512Ifma})
+        {
+            if (isa > detect_batch_isa())
+            {
+                continue;
+            }
+            mod_multiply_batch(multiply_a.data(), multiply_b.data(), batch_out.data(), multiply_a.size(), multiply_n, isa);
+            for (size_t i = 0; i < multiply_a.size(); i++)
+            {
+                assert(batch_out[i] == mod_multiply(multiply_a[i], multiply_b[i], multiply_n));
+            }
+            mod_sqr_batch(multiply_a.data(), batch_out.data(), multiply_a.size(), multiply_n, isa);
+            for (size_t i = 0; i < multiply_a.size(); i++)
+            {
+                assert(batch_out[i] == mod_sqr(multiply_a[i], multiply_n));
+            }
+            mod_multiply_add_batch(multiply_a.data(), multiply_b.data(), multiply_a.data(), batch_out.data(), multiply_a.size(), multiply_n, isa);
+            for (size_t i = 0; i < multiply_a.size(); i++)
+            {
+                assert(batch_out[i] == mod_add(mod_multiply(multiply_a[i], multiply_b[i], multiply_n), multiply_a[i], multiply_n));
+            }
+        }
+    }
+    const ShoupMultiplier shoup(97845874148483UL, 9223372036854775337UL);
+    std::cout << "Shoup: (7829454892340959985 * 97845874148483) % 9223372036854775337 = " << shoup.multiply(7829454892340959985UL) << std::endl;
+    assert(shoup.multiply(7829454892340959985UL) == mod_multiply(7829454892340959985UL % 9223372036854775337UL, 97845874148483UL, 9223372036854775337UL));
+    for (BatchIsa isa : {BatchIsa::Scalar, BatchIsa::Avx2, BatchIsa::Avx512})
+    {
+        if (isa > detect_batch_isa())
+        {
+            continue;
+        }
+        mod_multiply_constant_batch(batch_a.data(), batch_out.data(), batch_a.size(), shoup, isa);
+        for (size_t i = 0; i < batch_a.size(); i++)
+        {
+            assert(batch_out[i] == shoup.multiply(batch_a[i]));
+        }
+    }
+    // The dot product for moduli with 64 bits (carries are counted), 52 bits (IFMA) and 30 bits (32 bit lanes).
+    for (const uint64_t dot_n : {batch_n, 4503599627370449UL, 998244353UL})
+    {
+        std::vector<uint64_t> dot_a(1000);
+        std::vector<uint64_t> dot_b(1000);
+        uint64_t expected = 0;
+        for (size_t i = 0; i < dot_a.size(); i++)
+        {
+            dot_a[i] = dot_n - 1 - i;
+            dot_b[i] = (i * 7919) % dot_n;
+            expected = mod_add(expected, mod_multiply(dot_a[i], dot_b[i], dot_n), dot_n);
+        }
+        assert(mod_dot(dot_a.data(), dot_b.data(), dot_a.size(), dot_n) == expected);
+        for (BatchIsa isa : {BatchIsa::Scalar, BatchIsa::Avx2, BatchIsa::Avx512, BatchIsa::Avx512Ifma})
+        {
+            if (isa <= detect_batch_isa())
+            {
+                assert(mod_dot_batch(dot_a.data(), dot_b.data(), dot_a.size(), dot_n, isa) == expected);
+            }
+        }
+        std::cout << "mod_dot modulo " << dot_n << " = " << expected << std::endl;
+    }
+    mod_multiply_batch(batch_a.data(), batch_b.data(), batch_out.data(), batch_a.size(), batch_n);
+    std::cout << "Batch: (3577888489959895 * 1944674407370949273) % 13686744073709492732 = " << batch_out[2] << std::endl;
 }
\ No newline at end of file
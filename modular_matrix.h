@@ -0,0 +1,248 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+
+// This code multiplies dense matrices over Z_n (https://en.wikipedia.org/wiki/Matrix_multiplication).
+
+// A fixed set of worker threads, which process the iterations of parallel_for.
+// The workers are created once and wait for the next parallel_for, so repeated calls do not pay for thread creation.
+// The iterations are handed out one by one through an atomic counter, so uneven iterations balance themselves.
+class ThreadPool
+{
+public:
+    // Creates threads - 1 workers, the thread calling parallel_for is the last one.
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency())
+    {
+        for (size_t i = 1; i < threads; i++)
+        {
+            workers.emplace_back([this]()
+                                 { work(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        start.notify_all();
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Returns the number of threads, including the calling thread.
+    size_t size() const
+    {
+        return workers.size() + 1;
+    }
+
+    // Calls function(i) for all i < count on all threads and returns when all calls are done.
+    void parallel_for(size_t count, const std::function<void(size_t)> &function)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &function;
+            job_count = count;
+            next = 0;
+            busy_workers = workers.size();
+            generation++;
+        }
+        start.notify_all();
+        run(function, count);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]()
+                  { return busy_workers == 0; });
+        job = nullptr;
+    }
+
+private:
+    void run(const std::function<void(size_t)> &function, size_t count)
+    {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            function(i);
+        }
+    }
+
+    void work()
+    {
+        size_t seen_generation = 0;
+        while (true)
+        {
+            const std::function<void(size_t)> *function = nullptr;
+            size_t count = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                start.wait(lock, [&]()
+                           { return stop || generation != seen_generation; });
+                if (stop)
+                {
+                    return;
+                }
+                seen_generation = generation;
+                function = job;
+                count = job_count;
+            }
+            run(*function, count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy_workers--;
+            }
+            done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable done;
+    const std::function<void(size_t)> *job = nullptr;
+    size_t job_count = 0;
+    std::atomic<size_t> next{0};
+    size_t busy_workers = 0;
+    size_t generation = 0;
+    bool stop = false;
+};
+
+// The accumulator of one output element: sum + carries * 2^128 = sum of the products.
+struct ModMatmulAccumulator
+{
+    unsigned __int128 sum = 0;
+    uint64_t carries = 0;
+};
+
+// Adds the products a[0] * b[0] + ... + a[len - 1] * b[len - 1] to the accumulators of the 2 x 2 elements
+// (a0, a1) x (b0, b1) of a register tile. Every 128 bit product is added without reduction, the carries out of the
+// 128 bit sum are counted instead.
+inline void mod_matmul_kernel_2x2(const uint64_t *a0, const uint64_t *a1, const uint64_t *b0, const uint64_t *b1, size_t len,
+                                  ModMatmulAccumulator &c00, ModMatmulAccumulator &c01, ModMatmulAccumulator &c10, ModMatmulAccumulator &c11)
+{
+    unsigned __int128 s00 = c00.sum;
+    unsigned __int128 s01 = c01.sum;
+    unsigned __int128 s10 = c10.sum;
+    unsigned __int128 s11 = c11.sum;
+    uint64_t k00 = c00.carries;
+    uint64_t k01 = c01.carries;
+    uint64_t k10 = c10.carries;
+    uint64_t k11 = c11.carries;
+    for (size_t k = 0; k < len; k++)
+    {
+        const unsigned __int128 p00 = static_cast<unsigned __int128>(a0[k]) * b0[k];
+        const unsigned __int128 p01 = static_cast<unsigned __int128>(a0[k]) * b1[k];
+        const unsigned __int128 p10 = static_cast<unsigned __int128>(a1[k]) * b0[k];
+        const unsigned __int128 p11 = static_cast<unsigned __int128>(a1[k]) * b1[k];
+        s00 += p00;
+        s01 += p01;
+        s10 += p10;
+        s11 += p11;
+        k00 += s00 < p00;
+        k01 += s01 < p01;
+        k10 += s10 < p10;
+        k11 += s11 < p11;
+    }
+    c00 = {s00, k00};
+    c01 = {s01, k01};
+    c10 = {s10, k10};
+    c11 = {s11, k11};
+}
+
+// This function computes c = (a * b) % n for the rows x inner matrix a and the inner x cols matrix b.
+// All matrices are stored row by row, their elements have to be in Z_n.
+//
+// Delayed reduction: every output element accumulates its 128 bit products without reduction and counts the
+// carries out of 128 bits, so only one Barrett reduction per output element is needed:
+// sum + carries * 2^128 == BarrettReducer::reduce(sum) + carries * (2^128 % n) (mod n).
+// Cache tiling: b is transposed once, so both operands of a dot product are contiguous. The output is split into
+// tiles of tile_size x tile_size elements, and the inner dimension into blocks of block_size, so that the rows of
+// a and b of a block stay in the cache while all elements of the tile are accumulated.
+// Register tiling: the kernel computes 2 x 2 output elements at once, which loads 4 instead of 8 operands per
+// 4 products.
+// The output tiles are distributed over the threads of a ThreadPool.
+// From: Kazushige Goto and Robert A. van de Geijn, Anatomy of high-performance matrix multiplication
+// (https://doi.org/10.1145/1356052.1356053).
+inline void mod_matmul(const uint64_t *a, const uint64_t *b, uint64_t *c, size_t rows, size_t inner, size_t cols, uint64_t n, ThreadPool &pool)
+{
+    assert(n > 0);
+
+    constexpr size_t tile_size = 32;
+    constexpr size_t block_size = 256;
+
+    std::vector<uint64_t> b_transposed(inner * cols);
+    for (size_t k = 0; k < inner; k++)
+    {
+        for (size_t j = 0; j < cols; j++)
+        {
+            b_transposed[j * inner + k] = b[k * cols + j];
+        }
+    }
+
+    const BarrettReducer barrett(n);
+    const uint64_t r64 = static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 64) % n);
+    const uint64_t r128 = barrett.multiply(r64, r64);
+
+    const size_t row_tiles = (rows + tile_size - 1) / tile_size;
+    const size_t col_tiles = (cols + tile_size - 1) / tile_size;
+    pool.parallel_for(row_tiles * col_tiles, [&](size_t tile)
+                      {
+                          const size_t i0 = tile / col_tiles * tile_size;
+                          const size_t j0 = tile % col_tiles * tile_size;
+                          const size_t i1 = i0 + tile_size < rows ? i0 + tile_size : rows;
+                          const size_t j1 = j0 + tile_size < cols ? j0 + tile_size : cols;
+                          ModMatmulAccumulator accumulators[tile_size][tile_size];
+                          // A dummy accumulator and row for odd tile sizes, the kernel always computes 2 x 2 elements.
+                          ModMatmulAccumulator unused;
+                          for (size_t k0 = 0; k0 < inner; k0 += block_size)
+                          {
+                              const size_t len = k0 + block_size < inner ? block_size : inner - k0;
+                              for (size_t i = i0; i < i1; i += 2)
+                              {
+                                  const bool has_i1 = i + 1 < i1;
+                                  const uint64_t *a0 = a + i * inner + k0;
+                                  const uint64_t *a1 = has_i1 ? a0 + inner : a0;
+                                  for (size_t j = j0; j < j1; j += 2)
+                                  {
+                                      const bool has_j1 = j + 1 < j1;
+                                      const uint64_t *b0 = b_transposed.data() + j * inner + k0;
+                                      const uint64_t *b1 = has_j1 ? b0 + inner : b0;
+                                      ModMatmulAccumulator *row0 = accumulators[i - i0];
+                                      ModMatmulAccumulator *row1 = has_i1 ? accumulators[i - i0 + 1] : nullptr;
+                                      mod_matmul_kernel_2x2(a0, a1, b0, b1, len,
+                                                            row0[j - j0], has_j1 ? row0[j - j0 + 1] : unused,
+                                                            has_i1 ? row1[j - j0] : unused, has_i1 && has_j1 ? row1[j - j0 + 1] : unused);
+                                  }
+                              }
+                          }
+                          for (size_t i = i0; i < i1; i++)
+                          {
+                              for (size_t j = j0; j < j1; j++)
+                              {
+                                  const ModMatmulAccumulator &accumulator = accumulators[i - i0][j - j0];
+                                  const uint64_t carries = barrett.multiply(accumulator.carries % n, r128);
+                                  c[i * cols + j] = mod_add(barrett.reduce(accumulator.sum), carries, n);
+                              }
+                          } });
+}
+
+// Same as above, but with a temporary ThreadPool of the given number of threads.
+inline void mod_matmul(const uint64_t *a, const uint64_t *b, uint64_t *c, size_t rows, size_t inner, size_t cols, uint64_t n,
+                       size_t threads = std::thread::hardware_concurrency())
+{
+    ThreadPool pool(threads);
+    mod_matmul(a, b, c, rows, inner, cols, n, pool);
+}
@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <assert.h>
+
+#include "modular_matrix.h"
+
+// This code shows how to multiply matrices over Z_n with mod_matmul.
+// The matrix multiplication is implemented in modular_matrix.h.
+
+// Computes c = (a * b) % n with one reduction per product.
+std::vector<uint64_t> mod_matmul_naive(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b, size_t rows, size_t inner, size_t cols, uint64_t n)
+{
+    std::vector<uint64_t> c(rows * cols, 0);
+    for (size_t i = 0; i < rows; i++)
+    {
+        for (size_t j = 0; j < cols; j++)
+        {
+            for (size_t k = 0; k < inner; k++)
+            {
+                c[i * cols + j] = mod_add(c[i * cols + j], mod_multiply(a[i * inner + k], b[k * cols + j], n), n);
+            }
+        }
+    }
+    return c;
+}
+
+int main(int argc, char **argv)
+{
+    // The Fibonacci numbers from powers of {{1, 1}, {1, 0}}.
+    const uint64_t p = 1000000007;
+    const uint64_t q[] = {1, 1, 1, 0};
+    uint64_t f[] = {1, 0, 0, 1};
+    uint64_t t[4];
+    ThreadPool pool(2);
+    for (int i = 0; i < 90; i++)
+    {
+        mod_matmul(f, q, t, 2, 2, 2, p, pool);
+        std::copy(t, t + 4, f);
+    }
+    std::cout << "F(90) % " << p << " = " << f[1] << std::endl;
+    assert(f[1] == 2880067194370816120UL % p);
+
+    // Odd sizes, a modulus close to 2^64, where the 128 bit sums overflow, and an even modulus.
+    std::mt19937_64 generator(42);
+    for (const uint64_t n : {18446744073709551557UL, 18446744073709551614UL, 998244353UL, 2UL})
+    {
+        const size_t rows = 67;
+        const size_t inner = 301;
+        const size_t cols = 45;
+        std::vector<uint64_t> a(rows * inner);
+        std::vector<uint64_t> b(inner * cols);
+        for (uint64_t &x : a)
+        {
+            x = generator() % n;
+        }
+        for (uint64_t &x : b)
+        {
+            x = generator() % n;
+        }
+        std::vector<uint64_t> c(rows * cols);
+        mod_matmul(a.data(), b.data(), c.data(), rows, inner, cols, n, pool);
+        assert(c == mod_matmul_naive(a, b, rows, inner, cols, n));
+        std::cout << "67 x 301 times 301 x 45 modulo " << n << ": c[0] = " << c[0] << std::endl;
+    }
+}
@@ -0,0 +1,510 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <assert.h>
+
+// This code extends the modular arithmetic of modular_arithmetic.h to fixed width unsigned integers with Bits bits,
+// e.g. 128, 256, 512 or 1024 bits (https://en.wikipedia.org/wiki/Arbitrary-precision_arithmetic).
+// A number is stored as Bits / 64 limbs of 64 bits in little endian order in a std::array, so it lives on the stack
+// and no operation allocates memory. The limb operations use 128 bit intermediate results for the carries.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), chapter 14.2.
+
+template <size_t Bits>
+struct UInt
+{
+    static_assert(Bits > 0 && Bits % 64 == 0, "Bits has to be a multiple of 64");
+    static constexpr size_t limb_count = Bits / 64;
+
+    std::array<uint64_t, limb_count> limbs{};
+
+    constexpr UInt() = default;
+
+    constexpr UInt(uint64_t value)
+    {
+        limbs[0] = value;
+    }
+
+    // Parses a hexadecimal number without prefix, which has to fit into Bits bits.
+    static UInt from_hex(const std::string &hex)
+    {
+        UInt x;
+        size_t bit = 0;
+        for (size_t i = hex.size(); i-- > 0; bit += 4)
+        {
+            const char c = hex[i];
+            const uint64_t digit = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+            assert(digit < 16);
+            assert(bit < Bits || digit == 0);
+            if (bit < Bits)
+            {
+                x.limbs[bit / 64] |= digit << (bit % 64);
+            }
+        }
+        return x;
+    }
+
+    // Returns the hexadecimal representation without prefix and leading zeros.
+    std::string to_hex() const
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+        for (size_t bit = Bits; bit > 0; bit -= 4)
+        {
+            const uint64_t digit = (limbs[(bit - 4) / 64] >> ((bit - 4) % 64)) & 0xf;
+            if (digit != 0 || !hex.empty())
+            {
+                hex.push_back(digits[digit]);
+            }
+        }
+        return hex.empty() ? "0" : hex;
+    }
+
+    constexpr bool bit(size_t i) const
+    {
+        return (limbs[i / 64] >> (i % 64)) & 0x1;
+    }
+
+    // Returns the number of significant bits, i.e. 0 for 0.
+    constexpr size_t bit_width() const
+    {
+        for (size_t i = limb_count; i-- > 0;)
+        {
+            if (limbs[i] != 0)
+            {
+                return i * 64 + 64 - __builtin_clzll(limbs[i]);
+            }
+        }
+        return 0;
+    }
+
+    constexpr bool is_zero() const
+    {
+        for (const uint64_t limb : limbs)
+        {
+            if (limb != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend constexpr bool operator==(const UInt &a, const UInt &b)
+    {
+        return a.limbs == b.limbs;
+    }
+
+    friend constexpr bool operator!=(const UInt &a, const UInt &b)
+    {
+        return !(a == b);
+    }
+
+    friend constexpr bool operator<(const UInt &a, const UInt &b)
+    {
+        for (size_t i = limb_count; i-- > 0;)
+        {
+            if (a.limbs[i] != b.limbs[i])
+            {
+                return a.limbs[i] < b.limbs[i];
+            }
+        }
+        return false;
+    }
+
+    friend constexpr bool operator>=(const UInt &a, const UInt &b)
+    {
+        return !(a < b);
+    }
+};
+
+// Computes a[0..len) += b[0..len) and returns the carry.
+inline uint64_t limbs_add(uint64_t *a, const uint64_t *b, size_t len)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        const unsigned __int128 sum = static_cast<unsigned __int128>(a[i]) + b[i] + carry;
+        a[i] = static_cast<uint64_t>(sum);
+        carry = static_cast<uint64_t>(sum >> 64);
+    }
+    return carry;
+}
+
+// Computes a[0..len) -= b[0..len) and returns the borrow.
+inline uint64_t limbs_subtract(uint64_t *a, const uint64_t *b, size_t len)
+{
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        const unsigned __int128 difference = static_cast<unsigned __int128>(a[i]) - b[i] - borrow;
+        a[i] = static_cast<uint64_t>(difference);
+        borrow = static_cast<uint64_t>(difference >> 64) & 0x1;
+    }
+    return borrow;
+}
+
+// Adds the carry to a[0..len) and returns the carry out of the last limb.
+inline uint64_t limbs_propagate(uint64_t *a, uint64_t carry, size_t len)
+{
+    for (size_t i = 0; i < len && carry; i++)
+    {
+        a[i] += carry;
+        carry = a[i] < carry;
+    }
+    return carry;
+}
+
+// Computes out[0..2N) = a[0..N) * b[0..N) with N^2 limb multiplications.
+template <size_t N>
+void limbs_multiply_schoolbook(const uint64_t *a, const uint64_t *b, uint64_t *out)
+{
+    for (size_t i = 0; i < 2 * N; i++)
+    {
+        out[i] = 0;
+    }
+    for (size_t i = 0; i < N; i++)
+    {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < N; j++)
+        {
+            const unsigned __int128 t = static_cast<unsigned __int128>(a[i]) * b[j] + out[i + j] + carry;
+            out[i + j] = static_cast<uint64_t>(t);
+            carry = static_cast<uint64_t>(t >> 64);
+        }
+        out[i + N] = carry;
+    }
+}
+
+// Below this number of limbs, Karatsuba multiplication falls back to the schoolbook multiplication.
+constexpr size_t karatsuba_threshold = 8;
+
+// Computes out[0..2N) = a[0..N) * b[0..N) with Karatsuba multiplication
+// (https://en.wikipedia.org/wiki/Karatsuba_algorithm).
+// With a = a1 * B + a0 and b = b1 * B + b0 for B = 2^(64 * N / 2), the product is
+// z2 * B^2 + (z1 - z2 - z0) * B + z0 with z0 = a0 * b0, z2 = a1 * b1 and z1 = (a0 + a1) * (b0 + b1).
+// So 3 instead of 4 half size multiplications are needed, which recurse until karatsuba_threshold.
+// The sums a0 + a1 and b0 + b1 have one carry bit each, which is added separately to z1.
+template <size_t N>
+void limbs_multiply_karatsuba(const uint64_t *a, const uint64_t *b, uint64_t *out)
+{
+    if constexpr (N < karatsuba_threshold || N % 2 != 0)
+    {
+        limbs_multiply_schoolbook<N>(a, b, out);
+    }
+    else
+    {
+        constexpr size_t h = N / 2;
+
+        // z0 in out[0..2h), z2 in out[2h..4h).
+        limbs_multiply_karatsuba<h>(a, b, out);
+        limbs_multiply_karatsuba<h>(a + h, b + h, out + 2 * h);
+
+        std::array<uint64_t, h> a_sum;
+        std::array<uint64_t, h> b_sum;
+        std::copy(a, a + h, a_sum.begin());
+        std::copy(b, b + h, b_sum.begin());
+        const uint64_t a_carry = limbs_add(a_sum.data(), a + h, h);
+        const uint64_t b_carry = limbs_add(b_sum.data(), b + h, h);
+
+        // z1 = (a_carry * B + a_sum) * (b_carry * B + b_sum) with 2h + 1 limbs.
+        std::array<uint64_t, 2 * h + 1> z1;
+        limbs_multiply_karatsuba<h>(a_sum.data(), b_sum.data(), z1.data());
+        z1[2 * h] = a_carry & b_carry;
+        if (a_carry)
+        {
+            z1[2 * h] += limbs_add(z1.data() + h, b_sum.data(), h);
+        }
+        if (b_carry)
+        {
+            z1[2 * h] += limbs_add(z1.data() + h, a_sum.data(), h);
+        }
+
+        // z1 - z0 - z2 >= 0, so the borrows are absorbed by the top limb.
+        z1[2 * h] -= limbs_subtract(z1.data(), out, 2 * h);
+        z1[2 * h] -= limbs_subtract(z1.data(), out + 2 * h, 2 * h);
+
+        const uint64_t carry = limbs_add(out + h, z1.data(), 2 * h + 1);
+        limbs_propagate(out + 3 * h + 1, carry, h - 1);
+    }
+}
+
+// Computes sum = a + b and returns the carry.
+template <size_t Bits>
+uint64_t add_with_carry(const UInt<Bits> &a, const UInt<Bits> &b, UInt<Bits> &sum)
+{
+    sum = a;
+    return limbs_add(sum.limbs.data(), b.limbs.data(), UInt<Bits>::limb_count);
+}
+
+// Computes difference = a - b and returns the borrow, i.e. 1 if a < b.
+template <size_t Bits>
+uint64_t subtract_with_borrow(const UInt<Bits> &a, const UInt<Bits> &b, UInt<Bits> &difference)
+{
+    difference = a;
+    return limbs_subtract(difference.limbs.data(), b.limbs.data(), UInt<Bits>::limb_count);
+}
+
+// Returns the full product a * b with the schoolbook multiplication.
+template <size_t Bits>
+UInt<2 * Bits> multiply_schoolbook(const UInt<Bits> &a, const UInt<Bits> &b)
+{
+    UInt<2 * Bits> product;
+    limbs_multiply_schoolbook<UInt<Bits>::limb_count>(a.limbs.data(), b.limbs.data(), product.limbs.data());
+    return product;
+}
+
+// Returns the full product a * b with Karatsuba multiplication.
+template <size_t Bits>
+UInt<2 * Bits> multiply_karatsuba(const UInt<Bits> &a, const UInt<Bits> &b)
+{
+    UInt<2 * Bits> product;
+    limbs_multiply_karatsuba<UInt<Bits>::limb_count>(a.limbs.data(), b.limbs.data(), product.limbs.data());
+    return product;
+}
+
+// Returns the full product a * b, Karatsuba multiplication is used from karatsuba_threshold limbs on.
+template <size_t Bits>
+UInt<2 * Bits> multiply_full(const UInt<Bits> &a, const UInt<Bits> &b)
+{
+    return multiply_karatsuba(a, b);
+}
+
+// This function computes (a + b) % n for a, b < n.
+// The sum can have Bits + 1 bits, which the carry covers.
+template <size_t Bits>
+UInt<Bits> mod_add(const UInt<Bits> &a, const UInt<Bits> &b, const UInt<Bits> &n)
+{
+    assert(a < n);
+    assert(b < n);
+
+    UInt<Bits> sum;
+    const uint64_t carry = add_with_carry(a, b, sum);
+    if (carry || sum >= n)
+    {
+        subtract_with_borrow(sum, n, sum);
+    }
+    return sum;
+}
+
+// This function computes (a - b) % n for a, b < n.
+template <size_t Bits>
+UInt<Bits> mod_subtract(const UInt<Bits> &a, const UInt<Bits> &b, const UInt<Bits> &n)
+{
+    assert(a < n);
+    assert(b < n);
+
+    UInt<Bits> difference;
+    if (subtract_with_borrow(a, b, difference))
+    {
+        add_with_carry(difference, n, difference);
+    }
+    return difference;
+}
+
+// This function computes (a * b) % n for any modulus n > 0 with the double and add algorithm of
+// DoubleAndAddKernel, which needs no division, but 2 * Bits calls of mod_add, i.e. O(Bits^2 / 64) limb operations.
+// mod_multiply uses it for even moduli only.
+template <size_t Bits>
+UInt<Bits> mod_multiply_double_and_add(const UInt<Bits> &a, const UInt<Bits> &b, const UInt<Bits> &n)
+{
+    assert(a < n);
+    assert(b < n);
+
+    UInt<Bits> result;
+    for (size_t i = b.bit_width(); i-- > 0;)
+    {
+        result = mod_add(result, result, n);
+        if (b.bit(i))
+        {
+            result = mod_add(result, a, n);
+        }
+    }
+    return result;
+}
+
+// Montgomery multiplication for Bits bit numbers with R = 2^Bits, see MontgomeryContext.
+// The reduction works limb by limb: every step adds a multiple m * n of n, such that the lowest limb becomes 0,
+// which needs only n^-1 % 2^64 (operand scanning, HAC algorithm 14.32).
+// R % n and R^2 % n are computed by doubling with mod_add and a Montgomery power, so no multi-precision division
+// is needed.
+// Montgomery multiplication requires an odd modulus n.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), algorithm 14.32.
+template <size_t Bits>
+class UIntMontgomeryContext
+{
+public:
+    static constexpr size_t limb_count = UInt<Bits>::limb_count;
+
+    explicit UIntMontgomeryContext(const UInt<Bits> &n)
+        : n(n)
+    {
+        assert(n.limbs[0] & 0x1);
+
+        // Newton iteration for n^-1 % 2^64, see MontgomeryContext.
+        uint64_t inverse = n.limbs[0];
+        for (int i = 0; i < 5; i++)
+        {
+            inverse *= 2 - n.limbs[0] * inverse;
+        }
+        n_neg_inv = 0 - inverse;
+
+        // R % n by doubling 2^(w - 1) % n = 2^(w - 1) for the bit width w of n, which needs Bits - w + 1 doublings.
+        const size_t width = n.bit_width();
+        UInt<Bits> x;
+        if (width > 1)
+        {
+            x.limbs[(width - 1) / 64] = 1UL << ((width - 1) % 64);
+        }
+        for (size_t i = width; i <= Bits && width > 1; i++)
+        {
+            x = mod_add(x, x, n);
+        }
+        r = x;
+        // R^2 % n is 2^Bits in Montgomery form, i.e. the Montgomery power (2 * R)^Bits.
+        r2 = power(mod_add(r, r, n), UInt<64>(Bits));
+    }
+
+    const UInt<Bits> &modulus() const
+    {
+        return n;
+    }
+
+    // Returns the Montgomery form of 1, i.e. R % n.
+    const UInt<Bits> &one() const
+    {
+        return r;
+    }
+
+    // Converts a into Montgomery form: a * R % n.
+    UInt<Bits> to_montgomery(const UInt<Bits> &a) const
+    {
+        assert(a < n);
+        return multiply(a, r2);
+    }
+
+    // Converts a from Montgomery form back into Z_n: a * R^-1 % n.
+    UInt<Bits> from_montgomery(const UInt<Bits> &a) const
+    {
+        assert(a < n);
+        UInt<2 * Bits> t;
+        std::copy(a.limbs.begin(), a.limbs.end(), t.limbs.begin());
+        return reduce(t);
+    }
+
+    // This function computes (a * b * R^-1) % n, i.e. the product of two numbers in Montgomery form.
+    UInt<Bits> multiply(const UInt<Bits> &a, const UInt<Bits> &b) const
+    {
+        assert(a < n);
+        assert(b < n);
+        return reduce(multiply_full(a, b));
+    }
+
+    // This function computes (a * a * R^-1) % n.
+    UInt<Bits> square(const UInt<Bits> &a) const
+    {
+        return multiply(a, a);
+    }
+
+    // This function computes a^e in Montgomery form, where a is in Montgomery form.
+    // It is the same algorithm as mod_power, but with Montgomery multiplications.
+    template <size_t ExponentBits>
+    UInt<Bits> power(const UInt<Bits> &a, const UInt<ExponentBits> &e) const
+    {
+        assert(a < n);
+
+        UInt<Bits> y = r;
+        for (size_t i = e.bit_width(); i-- > 0;)
+        {
+            y = square(y);
+            if (e.bit(i))
+            {
+                y = multiply(y, a);
+            }
+        }
+        return y;
+    }
+
+private:
+    // Montgomery reduction computes t * R^-1 % n for t < n * R.
+    UInt<Bits> reduce(UInt<2 * Bits> t) const
+    {
+        // The carry out of the limb i + limb_count - 1 is delayed and added in the next step together with the
+        // carry of the row. The final carry is at most 1, since t + m * n < 2 * n * R.
+        uint64_t top = 0;
+        for (size_t i = 0; i < limb_count; i++)
+        {
+            const uint64_t m = t.limbs[i] * n_neg_inv;
+            uint64_t carry = 0;
+            for (size_t j = 0; j < limb_count; j++)
+            {
+                const unsigned __int128 s = static_cast<unsigned __int128>(m) * n.limbs[j] + t.limbs[i + j] + carry;
+                t.limbs[i + j] = static_cast<uint64_t>(s);
+                carry = static_cast<uint64_t>(s >> 64);
+            }
+            const unsigned __int128 s = static_cast<unsigned __int128>(t.limbs[i + limb_count]) + carry + top;
+            t.limbs[i + limb_count] = static_cast<uint64_t>(s);
+            top = static_cast<uint64_t>(s >> 64);
+        }
+        UInt<Bits> result;
+        std::copy(t.limbs.begin() + limb_count, t.limbs.end(), result.limbs.begin());
+        if (top || result >= n)
+        {
+            subtract_with_borrow(result, n, result);
+        }
+        return result;
+    }
+
+    UInt<Bits> n;
+    uint64_t n_neg_inv = 0; // -n^-1 % 2^64
+    UInt<Bits> r;           // R % n
+    UInt<Bits> r2;          // R^2 % n
+};
+
+// This function computes (a * b) % n for any modulus n > 0.
+// For odd n, it sets up a UIntMontgomeryContext and needs two Montgomery multiplications plus the setup (about
+// log2(Bits) Montgomery squarings), otherwise it falls back to the much slower mod_multiply_double_and_add.
+// The setup dominates, so for many multiplications with the same odd modulus, reuse a UIntMontgomeryContext.
+template <size_t Bits>
+UInt<Bits> mod_multiply(const UInt<Bits> &a, const UInt<Bits> &b, const UInt<Bits> &n)
+{
+    assert(a < n);
+    assert(b < n);
+
+    if (n.limbs[0] & 0x1)
+    {
+        // (a * R) * b * R^-1 = a * b.
+        const UIntMontgomeryContext<Bits> montgomery(n);
+        return montgomery.multiply(montgomery.to_montgomery(a), b);
+    }
+    return mod_multiply_double_and_add(a, b, n);
+}
+
+// This function computes (a^e) % n for a < n.
+// For odd n, it uses a UIntMontgomeryContext, otherwise square and multiply with mod_multiply_double_and_add.
+// The even case has no fast reduction, so every bit of e costs up to 4 * Bits multi-limb additions, which is
+// O(ExponentBits * Bits^2 / 64) limb operations in total.
+template <size_t Bits, size_t ExponentBits>
+UInt<Bits> mod_power(const UInt<Bits> &a, const UInt<ExponentBits> &e, const UInt<Bits> &n)
+{
+    assert(a < n);
+
+    if (n.limbs[0] & 0x1)
+    {
+        const UIntMontgomeryContext<Bits> montgomery(n);
+        return montgomery.from_montgomery(montgomery.power(montgomery.to_montgomery(a), e));
+    }
+    UInt<Bits> y = 1;
+    for (size_t i = e.bit_width(); i-- > 0;)
+    {
+        y = mod_multiply_double_and_add(y, y, n);
+        if (e.bit(i))
+        {
+            y = mod_multiply_double_and_add(y, a, n);
+        }
+    }
+    return y;
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <random>
+#include <assert.h>
+
+#include "multi_precision.h"
+
+// This code shows how to do modular arithmetic with fixed width multi-precision integers.
+// The functions are implemented in multi_precision.h.
+
+// Compares Karatsuba multiplication to schoolbook multiplication for random operands, all ones and only the highest
+// bits set, which carry through the middle term of every recursion level.
+template <size_t Bits>
+void check_karatsuba(std::mt19937_64 &generator)
+{
+    static_assert(UInt<Bits>::limb_count >= 2 * karatsuba_threshold, "The multiplication has to recurse.");
+    UInt<Bits> ones;
+    UInt<Bits> high;
+    for (size_t i = 0; i < UInt<Bits>::limb_count; i++)
+    {
+        ones.limbs[i] = ~0UL;
+        high.limbs[i] = 1UL << 63;
+    }
+    for (size_t round = 0; round < 100; round++)
+    {
+        UInt<Bits> a;
+        UInt<Bits> b;
+        for (size_t i = 0; i < UInt<Bits>::limb_count; i++)
+        {
+            a.limbs[i] = generator();
+            b.limbs[i] = generator();
+        }
+        for (const auto &[x, y] : {std::make_pair(a, b), std::make_pair(a, ones), std::make_pair(ones, high), std::make_pair(high, b)})
+        {
+            assert(multiply_schoolbook(x, y) == multiply_karatsuba(x, y));
+        }
+    }
+    assert(multiply_schoolbook(ones, ones) == multiply_karatsuba(ones, ones));
+    assert(multiply_schoolbook(high, high) == multiply_karatsuba(high, high));
+}
+
+int main(int argc, char **argv)
+{
+    // The prime 2^256 - 189.
+    const UInt<256> p = UInt<256>::from_hex("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff43");
+    const UInt<256> a = UInt<256>::from_hex("123456789abcdef0fedcba9876543210deadbeefcafebabe0123456789abcdef");
+    const UInt<256> b = UInt<256>::from_hex("fedcba9876543210123456789abcdef0cafebabedeadbeef9876543210fedcba");
+
+    std::cout << "(a + b) % p = " << mod_add(a, b, p).to_hex() << std::endl;
+    std::cout << "(a - b) % p = " << mod_subtract(a, b, p).to_hex() << std::endl;
+    std::cout << "(a * b) % p = " << mod_multiply(a, b, p).to_hex() << std::endl;
+    std::cout << "(a^b) % p = " << mod_power(a, b, p).to_hex() << std::endl;
+    assert(mod_multiply(a, b, p).to_hex() == "12b0154cb74d0f4b5a31b019cb8ae0b5418662b637d8bfaabf0b8a89b7ff130f");
+    assert(mod_power(a, b, p).to_hex() == "27da32b4de16a4a9e11c6a34e8092a9e93b3f22d8acd523126280359619bfe5c");
+    assert(mod_add(mod_subtract(a, b, p), b, p) == a);
+
+    // Montgomery multiplication with a context, as for many multiplications with the same modulus.
+    const UIntMontgomeryContext<256> montgomery(p);
+    const UInt<256> product = montgomery.from_montgomery(montgomery.multiply(montgomery.to_montgomery(a), montgomery.to_montgomery(b)));
+    std::cout << "Montgomery: (a * b) % p = " << product.to_hex() << std::endl;
+    assert(product == mod_multiply(a, b, p));
+    assert(product == mod_multiply_double_and_add(a, b, p));
+
+    // mod_multiply and mod_power with an even modulus use double and add.
+    const UInt<256> even = UInt<256>::from_hex("fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe");
+    assert(mod_multiply(a, b, even) == mod_multiply_double_and_add(a, b, even));
+    assert(mod_multiply(a, b, even) == UInt<256>::from_hex("d5962d614ea939a12fafcc9739451227866254dafc010739e9cab1e64bd007c4"));
+
+    // Fermat's little theorem for the Mersenne prime 2^607 - 1 with 1024 bit numbers: 3^(m - 1) % m = 1.
+    UInt<1024> m;
+    for (size_t i = 0; i < 607; i++)
+    {
+        m.limbs[i / 64] |= 1UL << (i % 64);
+    }
+    UInt<1024> m_minus_one;
+    subtract_with_borrow(m, UInt<1024>(1), m_minus_one);
+    std::cout << "(3^(2^607 - 2)) % (2^607 - 1) = " << mod_power(UInt<1024>(3), m_minus_one, m).to_hex() << std::endl;
+    assert(mod_power(UInt<1024>(3), m_minus_one, m) == UInt<1024>(1));
+
+    // 1024 and 2048 bit numbers have 16 and 32 limbs, so Karatsuba multiplication recurses once and twice.
+    std::mt19937_64 generator(42);
+    check_karatsuba<1024>(generator);
+    check_karatsuba<2048>(generator);
+    std::cout << "Karatsuba multiplication of 1024 and 2048 bit numbers equals schoolbook multiplication" << std::endl;
+}
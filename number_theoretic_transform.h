@@ -0,0 +1,457 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+
+// This code multiplies polynomials over Z_p with the number theoretic transform (NTT), i.e. the discrete Fourier
+// transform over Z_p instead of the complex numbers (https://en.wikipedia.org/wiki/Number-theoretic_transform).
+// The product of two polynomials with m and k coefficients is the inverse transform of the element-wise product
+// of their transforms, which needs O(s log(s)) instead of O(m * k) multiplications for a transform size s >= m + k - 1.
+// The transform size s has to be a power of two, so p has to be a prime with s | p - 1 ("NTT friendly" prime).
+
+// NTT friendly primes p = c * 2^k + 1 below 2^62, which allow transforms up to the size 2^k.
+constexpr uint64_t ntt_prime_57 = 4179340454199820289UL; // 29 * 2^57 + 1
+constexpr uint64_t ntt_prime_55 = 2485986994308513793UL; // 69 * 2^55 + 1
+constexpr uint64_t ntt_prime_54 = 2287828610704211969UL; // 127 * 2^54 + 1
+constexpr uint64_t ntt_prime_23 = 998244353UL;           // 119 * 2^23 + 1
+
+// Returns the smallest power of two which is >= size.
+inline size_t ntt_size(size_t size)
+{
+    size_t power = 1;
+    while (power < size)
+    {
+        power <<= 1;
+    }
+    return power;
+}
+
+// Forward and inverse transforms of the sizes 1, 2, 4, ..., max_size for one NTT friendly prime p.
+// The forward transform is a decimation in frequency transform, which takes the coefficients in natural order
+// and returns the transform in bit reversed order. The inverse transform is a decimation in time transform,
+// which takes the bit reversed order. Therefore, no bit reversal permutation is needed for a multiplication.
+//
+// The transforms use radix-4 butterflies, which need 3 instead of 4 twiddle multiplications per 4 elements
+// and half of the passes over the array compared to radix-2. For odd log2(size), the last forward and the first
+// inverse pass is a radix-2 pass without twiddle factors.
+// The passes on lengths larger than block_size go over the whole array. All smaller lengths are transformed
+// block by block, so that a block stays in the cache for all its passes.
+//
+// The twiddle factors w^j, w^2j, w^3j of every length are precomputed in Montgomery form, so a Montgomery
+// multiplication of a coefficient with a twiddle factor results in a normal product and the coefficients are
+// never converted. The reduction is lazy: coefficients are kept in [0, 2p), sums and differences in [0, 4p),
+// and the Montgomery reduction skips its final correction. This needs p < 2^62, so that 4p fits into 64 bits.
+// From: Matters Computational (https://www.jjj.de/fxt/fxtbook.pdf), chapters 21 and 26 and
+// David Harvey, Faster arithmetic for number-theoretic transforms (https://doi.org/10.1016/j.jsc.2013.09.002).
+class NumberTheoreticTransform
+{
+public:
+    // p has to be a prime below 2^62 and max_size a power of two which divides p - 1.
+    NumberTheoreticTransform(uint64_t p, size_t max_size)
+        : p(p), max_transform_size(max_size), montgomery(p)
+    {
+        assert(p < (1UL << 62));
+        assert(max_size > 0 && (max_size & (max_size - 1)) == 0);
+        assert((p - 1) % max_size == 0);
+
+        p_inv = p;
+        for (int i = 0; i < 5; i++)
+        {
+            p_inv *= 2 - p * p_inv;
+        }
+
+        // x^((p - 1) / max_size) has the order max_size for any quadratic non-residue x,
+        // since x^((p - 1) / 2) == -1 means that the order of x contains the full power of two of p - 1.
+        uint64_t non_residue = 2;
+        while (mod_power(non_residue, (p - 1) / 2, p) != p - 1)
+        {
+            non_residue++;
+        }
+        const uint64_t root = montgomery.power(montgomery.to_montgomery(non_residue), (p - 1) / max_size);
+        const uint64_t inverse_root = montgomery.power(root, max_size - 1);
+
+        // The twiddle factors of the length m are stored at [m / 4, m / 2).
+        forward_twiddles.resize(max_size / 2);
+        inverse_twiddles.resize(max_size / 2);
+        for (size_t m = 4; m <= max_size; m <<= 1)
+        {
+            const uint64_t w = montgomery.power(root, max_size / m);
+            const uint64_t inverse_w = montgomery.power(inverse_root, max_size / m);
+            uint64_t w_j = montgomery.one();
+            uint64_t inverse_w_j = montgomery.one();
+            for (size_t j = 0; j < m / 4; j++)
+            {
+                const uint64_t w_2j = montgomery.square(w_j);
+                const uint64_t inverse_w_2j = montgomery.square(inverse_w_j);
+                forward_twiddles[m / 4 + j] = {w_j, w_2j, montgomery.multiply(w_j, w_2j)};
+                inverse_twiddles[m / 4 + j] = {inverse_w_j, inverse_w_2j, montgomery.multiply(inverse_w_j, inverse_w_2j)};
+                w_j = montgomery.multiply(w_j, w);
+                inverse_w_j = montgomery.multiply(inverse_w_j, inverse_w);
+            }
+        }
+        if (max_size >= 4)
+        {
+            // The primitive 4th root of unity, i.e. the twiddle factor w^(m / 4) of every length m.
+            imaginary = montgomery.power(root, max_size / 4);
+            inverse_imaginary = montgomery.power(inverse_root, max_size / 4);
+        }
+    }
+
+    uint64_t modulus() const
+    {
+        return p;
+    }
+
+    size_t max_size() const
+    {
+        return max_transform_size;
+    }
+
+    // Transforms a[0], ..., a[size - 1] in place, the result is in bit reversed order.
+    // The coefficients have to be in [0, p), size has to be a power of two <= max_size().
+    void forward(uint64_t *a, size_t size) const
+    {
+        forward_lazy(a, size);
+        for (size_t i = 0; i < size; i++)
+        {
+            a[i] = a[i] >= p ? a[i] - p : a[i];
+        }
+    }
+
+    // Inverts forward in place, i.e. takes the transform in bit reversed order and returns the coefficients.
+    void inverse(uint64_t *a, size_t size) const
+    {
+        inverse_lazy(a, size, montgomery.to_montgomery(size_inverse(size)));
+    }
+
+    // Returns the product of the polynomials a[0] + a[1] * x + ... and b[0] + b[1] * x + ...,
+    // which has a.size() + b.size() - 1 coefficients. The coefficients have to be in [0, p).
+    std::vector<uint64_t> multiply(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) const
+    {
+        if (a.empty() || b.empty())
+        {
+            return {};
+        }
+        const size_t result_size = a.size() + b.size() - 1;
+        const size_t size = ntt_size(result_size);
+        assert(size <= max_transform_size);
+
+        std::vector<uint64_t> fa(size, 0);
+        std::vector<uint64_t> fb(size, 0);
+        std::copy(a.begin(), a.end(), fa.begin());
+        std::copy(b.begin(), b.end(), fb.begin());
+        forward_lazy(fa.data(), size);
+        forward_lazy(fb.data(), size);
+        for (size_t i = 0; i < size; i++)
+        {
+            fa[i] = multiply_lazy(fa[i], fb[i]);
+        }
+        // The element-wise Montgomery multiplications introduced a factor R^-1, which the scaling compensates.
+        inverse_lazy(fa.data(), size, montgomery.to_montgomery(montgomery.to_montgomery(size_inverse(size))));
+        fa.resize(result_size);
+        return fa;
+    }
+
+private:
+    struct Twiddles
+    {
+        uint64_t w1; // w^j
+        uint64_t w2; // w^2j
+        uint64_t w3; // w^3j
+    };
+
+    // The passes on smaller lengths are done block by block, 2^14 coefficients are 128 KiB.
+    static constexpr size_t block_size = 1 << 14;
+
+    // Returns a * b * R^-1 (mod p) in [0, 2p) for a * b < 4p^2.
+    // This is MontgomeryContext::reduce without the final correction.
+    uint64_t multiply_lazy(uint64_t a, uint64_t b) const
+    {
+        const unsigned __int128 t = static_cast<unsigned __int128>(a) * b;
+        const uint64_t m = static_cast<uint64_t>(t) * p_inv;
+        const uint64_t mp_high = static_cast<uint64_t>((static_cast<unsigned __int128>(m) * p) >> 64);
+        return static_cast<uint64_t>(t >> 64) - mp_high + p;
+    }
+
+    // Reduces a in [0, 4p) to [0, 2p).
+    uint64_t reduce_twice(uint64_t a) const
+    {
+        return a >= 2 * p ? a - 2 * p : a;
+    }
+
+    uint64_t size_inverse(size_t size) const
+    {
+        return mod_inverse(size % p, p).value();
+    }
+
+    // Returns the length of the blocks, which is the largest pass length <= block_size.
+    static size_t block_length(size_t size)
+    {
+        size_t length = size;
+        while (length > block_size)
+        {
+            length /= 4;
+        }
+        return length;
+    }
+
+    // Radix-4 decimation in frequency butterflies of the length m on a[0], ..., a[len - 1].
+    void forward_pass(uint64_t *a, size_t len, size_t m) const
+    {
+        const size_t quarter = m / 4;
+        const Twiddles *twiddles = forward_twiddles.data() + quarter;
+        for (size_t base = 0; base < len; base += m)
+        {
+            uint64_t *a0 = a + base;
+            uint64_t *a1 = a0 + quarter;
+            uint64_t *a2 = a1 + quarter;
+            uint64_t *a3 = a2 + quarter;
+            for (size_t j = 0; j < quarter; j++)
+            {
+                const uint64_t t0 = reduce_twice(a0[j] + a2[j]);
+                const uint64_t t1 = reduce_twice(a0[j] + 2 * p - a2[j]);
+                const uint64_t t2 = reduce_twice(a1[j] + a3[j]);
+                const uint64_t t3 = multiply_lazy(a1[j] + 2 * p - a3[j], imaginary);
+                a0[j] = reduce_twice(t0 + t2);
+                a1[j] = multiply_lazy(t0 + 2 * p - t2, twiddles[j].w2);
+                a2[j] = multiply_lazy(t1 + t3, twiddles[j].w1);
+                a3[j] = multiply_lazy(t1 + 2 * p - t3, twiddles[j].w3);
+            }
+        }
+    }
+
+    // Radix-4 decimation in time butterflies of the length m on a[0], ..., a[len - 1], which invert forward_pass.
+    void inverse_pass(uint64_t *a, size_t len, size_t m) const
+    {
+        const size_t quarter = m / 4;
+        const Twiddles *twiddles = inverse_twiddles.data() + quarter;
+        for (size_t base = 0; base < len; base += m)
+        {
+            uint64_t *a0 = a + base;
+            uint64_t *a1 = a0 + quarter;
+            uint64_t *a2 = a1 + quarter;
+            uint64_t *a3 = a2 + quarter;
+            for (size_t j = 0; j < quarter; j++)
+            {
+                const uint64_t b1 = multiply_lazy(a1[j], twiddles[j].w2);
+                const uint64_t b2 = multiply_lazy(a2[j], twiddles[j].w1);
+                const uint64_t b3 = multiply_lazy(a3[j], twiddles[j].w3);
+                const uint64_t u0 = reduce_twice(a0[j] + b1);
+                const uint64_t u1 = reduce_twice(a0[j] + 2 * p - b1);
+                const uint64_t s = reduce_twice(b2 + b3);
+                const uint64_t d = multiply_lazy(b2 + 2 * p - b3, inverse_imaginary);
+                a0[j] = reduce_twice(u0 + s);
+                a1[j] = reduce_twice(u1 + d);
+                a2[j] = reduce_twice(u0 + 2 * p - s);
+                a3[j] = reduce_twice(u1 + 2 * p - d);
+            }
+        }
+    }
+
+    // Radix-2 butterflies of the length 2, which need no twiddle factors and are their own inverse up to a factor 2.
+    void radix2_pass(uint64_t *a, size_t len) const
+    {
+        for (size_t i = 0; i < len; i += 2)
+        {
+            const uint64_t a0 = a[i];
+            const uint64_t a1 = a[i + 1];
+            a[i] = reduce_twice(a0 + a1);
+            a[i + 1] = reduce_twice(a0 + 2 * p - a1);
+        }
+    }
+
+    // Forward transform with the coefficients in [0, 2p).
+    void forward_lazy(uint64_t *a, size_t size) const
+    {
+        assert(size > 0 && (size & (size - 1)) == 0);
+        assert(size <= max_transform_size);
+
+        const size_t block = block_length(size);
+        size_t m = size;
+        for (; m > block; m /= 4)
+        {
+            forward_pass(a, size, m);
+        }
+        for (size_t base = 0; base < size; base += block)
+        {
+            size_t block_m = m;
+            for (; block_m >= 4; block_m /= 4)
+            {
+                forward_pass(a + base, block, block_m);
+            }
+            if (block_m == 2)
+            {
+                radix2_pass(a + base, block);
+            }
+        }
+    }
+
+    // Inverse transform, which multiplies the coefficients with scale (in Montgomery form) and returns them in [0, p).
+    void inverse_lazy(uint64_t *a, size_t size, uint64_t scale) const
+    {
+        assert(size > 0 && (size & (size - 1)) == 0);
+        assert(size <= max_transform_size);
+
+        const size_t block = block_length(size);
+        // The lengths of the passes are 2 (for odd log2(size)) or 4, multiplied by powers of 4.
+        const size_t first_m = (__builtin_ctzll(size) & 0x1) ? 8 : 4;
+        for (size_t base = 0; base < size; base += block)
+        {
+            if (first_m == 8)
+            {
+                radix2_pass(a + base, block);
+            }
+            for (size_t m = first_m; m <= block; m *= 4)
+            {
+                inverse_pass(a + base, block, m);
+            }
+        }
+        for (size_t m = block * 4; m <= size; m *= 4)
+        {
+            inverse_pass(a, size, m);
+        }
+        for (size_t i = 0; i < size; i++)
+        {
+            const uint64_t x = multiply_lazy(a[i], scale);
+            a[i] = x >= p ? x - p : x;
+        }
+    }
+
+    uint64_t p;
+    uint64_t p_inv; // p^-1 % 2^64
+    size_t max_transform_size;
+    MontgomeryContext montgomery;
+    uint64_t imaginary = 0;
+    uint64_t inverse_imaginary = 0;
+    std::vector<Twiddles> forward_twiddles;
+    std::vector<Twiddles> inverse_twiddles;
+};
+
+// Returns the product of the polynomials a and b over Z_p, see NumberTheoreticTransform::multiply.
+// p has to be an NTT friendly prime below 2^62, whose p - 1 is divisible by the transform size.
+inline std::vector<uint64_t> poly_multiply(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b, uint64_t p)
+{
+    if (a.empty() || b.empty())
+    {
+        return {};
+    }
+    const NumberTheoreticTransform ntt(p, ntt_size(a.size() + b.size() - 1));
+    return ntt.multiply(a, b);
+}
+
+// Calls function(t) for all t < count, distributed round robin over threads threads.
+template <class Function>
+void ntt_parallel_for(size_t count, size_t threads, Function function)
+{
+    assert(threads > 0);
+
+    if (threads == 1 || count <= 1)
+    {
+        for (size_t t = 0; t < count; t++)
+        {
+            function(t);
+        }
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t thread = 0; thread < threads && thread < count; thread++)
+    {
+        workers.emplace_back([=]()
+                             {
+                                 for (size_t t = thread; t < count; t += threads)
+                                 {
+                                     function(t);
+                                 } });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Returns x * y as three 64 bit limbs, the most significant limb first, so that products compare as arrays.
+inline std::array<uint64_t, 3> ntt_multiply_192(unsigned __int128 x, uint64_t y)
+{
+    const unsigned __int128 low = static_cast<unsigned __int128>(static_cast<uint64_t>(x)) * y;
+    const unsigned __int128 high = static_cast<unsigned __int128>(static_cast<uint64_t>(x >> 64)) * y;
+    const unsigned __int128 middle = (low >> 64) + static_cast<uint64_t>(high);
+    return {static_cast<uint64_t>(high >> 64) + static_cast<uint64_t>(middle >> 64), static_cast<uint64_t>(middle), static_cast<uint64_t>(low)};
+}
+
+// Returns the product of the polynomials a and b over Z_n for any modulus n, whose coefficients have to be in [0, n).
+// If n is not an NTT friendly prime, the product cannot be transformed modulo n. Instead, the product is computed
+// over the integers: every coefficient is a sum of at most min(a.size(), b.size()) products <= (n - 1)^2.
+// The product is computed modulo the three NTT friendly primes p1 = ntt_prime_57, p2 = ntt_prime_55 and
+// p3 = ntt_prime_54, and the integer coefficients are recombined from their residues with the Chinese remainder
+// theorem (https://en.wikipedia.org/wiki/Chinese_remainder_theorem). The recombination is unique if every
+// coefficient is smaller than p1 * p2 * p3 (about 2^183.96), i.e. min(a.size(), b.size()) * (n - 1)^2 < p1 * p2 * p3,
+// which is asserted. For n <= 2^64, this allows inputs with up to 2^55 coefficients.
+// Garner's algorithm determines the coefficient as x = r1 + p1 * k2 + p1 * p2 * k3 with k2 < p2 and k3 < p3,
+// so x % n only needs single precision modular arithmetic.
+// The three products are independent and run on up to threads threads, the recombination is split into
+// threads chunks.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), algorithm 14.71.
+inline std::vector<uint64_t> mod_convolution(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b, uint64_t n, size_t threads = 3)
+{
+    assert(n > 0);
+    assert(threads > 0);
+
+    if (a.empty() || b.empty())
+    {
+        return {};
+    }
+    const uint64_t primes[3] = {ntt_prime_57, ntt_prime_55, ntt_prime_54};
+    assert(ntt_multiply_192(static_cast<unsigned __int128>(n - 1) * (n - 1), std::min(a.size(), b.size())) <
+           ntt_multiply_192(static_cast<unsigned __int128>(primes[0]) * primes[1], primes[2]));
+    const size_t result_size = a.size() + b.size() - 1;
+    const size_t size = ntt_size(result_size);
+
+    std::vector<uint64_t> residues[3];
+    ntt_parallel_for(3, threads, [&](size_t k)
+                     {
+                         const uint64_t p = primes[k];
+                         std::vector<uint64_t> a_p(a.size());
+                         std::vector<uint64_t> b_p(b.size());
+                         for (size_t i = 0; i < a.size(); i++)
+                         {
+                             a_p[i] = a[i] % p;
+                         }
+                         for (size_t i = 0; i < b.size(); i++)
+                         {
+                             b_p[i] = b[i] % p;
+                         }
+                         residues[k] = NumberTheoreticTransform(p, size).multiply(a_p, b_p); });
+
+    const uint64_t p1 = primes[0];
+    const uint64_t p2 = primes[1];
+    const uint64_t p3 = primes[2];
+    const uint64_t p1_inverse_p2 = mod_inverse(p1 % p2, p2).value();
+    const uint64_t p1_p3 = p1 % p3;
+    const uint64_t p1_p2_inverse_p3 = mod_inverse(mod_multiply(p1_p3, p2 % p3, p3), p3).value();
+    const uint64_t p1_n = p1 % n;
+    const uint64_t p1_p2_n = mod_multiply(p1_n, p2 % n, n);
+
+    std::vector<uint64_t> c(result_size);
+    const size_t chunks = threads < result_size ? threads : result_size;
+    const size_t chunk = (result_size + chunks - 1) / chunks;
+    ntt_parallel_for(chunks, chunks, [&](size_t t)
+                     {
+                         const size_t end = (t + 1) * chunk < result_size ? (t + 1) * chunk : result_size;
+                         for (size_t i = t * chunk; i < end; i++)
+                         {
+                             const uint64_t r1 = residues[0][i];
+                             const uint64_t k2 = mod_multiply(mod_subtract(residues[1][i], r1 % p2, p2), p1_inverse_p2, p2);
+                             const uint64_t x12_p3 = mod_add(r1 % p3, mod_multiply(p1_p3, k2 % p3, p3), p3);
+                             const uint64_t k3 = mod_multiply(mod_subtract(residues[2][i], x12_p3, p3), p1_p2_inverse_p3, p3);
+                             const uint64_t x12_n = mod_add(r1 % n, mod_multiply(p1_n, k2 % n, n), n);
+                             c[i] = mod_add(x12_n, mod_multiply(p1_p2_n, k3 % n, n), n);
+                         } });
+    return c;
+}
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+#include "number_theoretic_transform.h"
+
+// This code shows how to multiply polynomials over Z_p with the number theoretic transform.
+// The transforms are implemented in number_theoretic_transform.h.
+
+// Returns the product of the polynomials a and b over Z_p with O(a.size() * b.size()) multiplications.
+std::vector<uint64_t> poly_multiply_schoolbook(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b, uint64_t p)
+{
+    std::vector<uint64_t> c(a.size() + b.size() - 1, 0);
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        for (size_t j = 0; j < b.size(); j++)
+        {
+            c[i + j] = mod_add(c[i + j], mod_multiply(a[i], b[j], p), p);
+        }
+    }
+    return c;
+}
+
+void print_polynomial(const std::vector<uint64_t> &a)
+{
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        std::cout << (i ? " + " : "") << a[i] << "x^" << i;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    // (1 + 2x + 3x^2) * (4 + 5x) = 4 + 13x + 22x^2 + 15x^3
+    const std::vector<uint64_t> a = {1, 2, 3};
+    const std::vector<uint64_t> b = {4, 5};
+    const std::vector<uint64_t> c = poly_multiply(a, b, ntt_prime_23);
+    std::cout << "(1 + 2x + 3x^2) * (4 + 5x) mod " << ntt_prime_23 << " = ";
+    print_polynomial(c);
+    assert(c == std::vector<uint64_t>({4, 13, 22, 15}));
+
+    // (-1 + x)^2 = 1 - 2x + x^2 with -1 == p - 1.
+    const uint64_t p = ntt_prime_57;
+    const std::vector<uint64_t> d = {p - 1, 1};
+    const std::vector<uint64_t> e = poly_multiply(d, d, p);
+    std::cout << "(" << p - 1 << " + x)^2 mod " << p << " = ";
+    print_polynomial(e);
+    assert(e == std::vector<uint64_t>({1, p - 2, 1}));
+
+    // One engine serves all transform sizes up to its maximal size.
+    const NumberTheoreticTransform ntt(p, 1 << 12);
+    std::vector<uint64_t> f(1000);
+    std::vector<uint64_t> g(777);
+    for (size_t i = 0; i < f.size(); i++)
+    {
+        f[i] = mod_power(3, i, p);
+    }
+    for (size_t i = 0; i < g.size(); i++)
+    {
+        g[i] = mod_power(5, i * i, p);
+    }
+    const std::vector<uint64_t> h = ntt.multiply(f, g);
+    assert(h == poly_multiply_schoolbook(f, g, p));
+    std::cout << "Product of degree " << f.size() - 1 << " and " << g.size() - 1 << ": coefficient 1000 = " << h[1000] << std::endl;
+
+    // forward and inverse are inverse to each other.
+    std::vector<uint64_t> transform = f;
+    transform.resize(1 << 10);
+    ntt.forward(transform.data(), transform.size());
+    ntt.inverse(transform.data(), transform.size());
+    assert(std::equal(f.begin(), f.end(), transform.begin()));
+
+    // Convolution modulo a modulus which is not NTT friendly, here 2^64 - 1 (not a prime).
+    const uint64_t n = 18446744073709551615UL;
+    std::vector<uint64_t> x(300);
+    std::vector<uint64_t> y(500);
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        x[i] = n - 1 - i;
+    }
+    for (size_t i = 0; i < y.size(); i++)
+    {
+        y[i] = mod_power(7, i, n);
+    }
+    const std::vector<uint64_t> z = mod_convolution(x, y, n);
+    assert(z == poly_multiply_schoolbook(x, y, n));
+    assert(mod_convolution(x, y, n, 1) == z);
+    std::cout << "Convolution mod " << n << ": coefficient 400 = " << z[400] << std::endl;
+}
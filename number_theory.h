@@ -0,0 +1,794 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+
+// This code implements number theoretic algorithms for 64 bit integers on top of modular_arithmetic.h.
+
+// The primes below 64, which are used for trial division.
+constexpr uint64_t small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+
+// Returns true if n is a strong probable prime to the base a, n has to be odd and the base in Montgomery form.
+// With n - 1 = d * 2^s and d odd, a prime n satisfies either a^d == 1 or a^(d * 2^r) == -1 for some r < s.
+inline bool is_strong_probable_prime(const MontgomeryContext &montgomery, uint64_t a, uint64_t d, int s)
+{
+    const uint64_t n = montgomery.modulus();
+    const uint64_t one = montgomery.one();
+    const uint64_t minus_one = n - one;
+    uint64_t x = montgomery.power(a, d);
+    if (x == one || x == minus_one)
+    {
+        return true;
+    }
+    for (int r = 1; r < s; r++)
+    {
+        x = montgomery.square(x);
+        if (x == minus_one)
+        {
+            return true;
+        }
+        if (x == one)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Returns true if n is a prime (https://en.wikipedia.org/wiki/Miller%E2%80%93Rabin_primality_test).
+// Small factors are found by trial division with the primes below 64, which rejects about 70% of all odd numbers.
+// The remaining numbers are tested with the Miller-Rabin test. Every composite n < 2^64 fails the test for at least
+// one of the 7 bases 2, 325, 9375, 28178, 450775, 9780504 and 1795265022, so the result is deterministic.
+// The exponentiations use Montgomery multiplication, n is odd at this point.
+// From: Jim Sinclair's base set, see https://miller-rabin.appspot.com.
+inline bool is_prime(uint64_t n)
+{
+    if (n < 2)
+    {
+        return false;
+    }
+    for (const uint64_t p : small_primes)
+    {
+        if (n % p == 0)
+        {
+            return n == p;
+        }
+    }
+    if (n < 64 * 64)
+    {
+        return true;
+    }
+
+    uint64_t d = n - 1;
+    const int s = __builtin_ctzll(d);
+    d >>= s;
+    const MontgomeryContext montgomery(n);
+    for (const uint64_t base : {2UL, 325UL, 9375UL, 28178UL, 450775UL, 9780504UL, 1795265022UL})
+    {
+        const uint64_t a = base % n;
+        if (a == 0)
+        {
+            continue;
+        }
+        if (!is_strong_probable_prime(montgomery, montgomery.to_montgomery(a), d, s))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the smallest prime >= n, or std::nullopt if there is none below 2^64.
+inline std::optional<uint64_t> next_prime(uint64_t n)
+{
+    // The largest prime below 2^64.
+    if (n > 18446744073709551557UL)
+    {
+        return std::nullopt;
+    }
+    if (n <= 2)
+    {
+        return 2;
+    }
+    n |= 0x1;
+    while (!is_prime(n))
+    {
+        n += 2;
+    }
+    return n;
+}
+
+// This function sets out[i] = is_prime(in[i]) for all i < len and returns the number of primes.
+// The array is split into threads chunks, which are tested in parallel. By default, all hardware threads are used.
+inline size_t is_prime_batch(const uint64_t *in, bool *out, size_t len, size_t threads = std::thread::hardware_concurrency())
+{
+    threads = threads > 0 ? threads : 1;
+
+    const auto test_range = [in, out](size_t begin, size_t end)
+    {
+        size_t primes = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            out[i] = is_prime(in[i]);
+            primes += out[i];
+        }
+        return primes;
+    };
+
+    const size_t chunk = (len + threads - 1) / threads;
+    if (threads == 1 || chunk == 0)
+    {
+        return test_range(0, len);
+    }
+
+    std::vector<size_t> primes(threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++)
+    {
+        const size_t begin = t * chunk < len ? t * chunk : len;
+        const size_t end = begin + chunk < len ? begin + chunk : len;
+        workers.emplace_back([=, &primes]()
+                             { primes[t] = test_range(begin, end); });
+    }
+    size_t total = 0;
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers[t].join();
+        total += primes[t];
+    }
+    return total;
+}
+
+// Returns a non-trivial divisor of the odd composite n with Pollard's rho algorithm
+// (https://en.wikipedia.org/wiki/Pollard%27s_rho_algorithm).
+// The sequence x_(i+1) = x_i^2 + c (mod n) becomes periodic modulo every prime factor p of n after about sqrt(p)
+// steps, then gcd(x_i - x_j, n) is a multiple of p. Brent's variant compares x_j to the fixed x_i with
+// i = 2^k - 1 and i < j <= 2^(k+1) - 1, which finds the cycle without a second sequence.
+// Instead of one GCD per step, the differences of batch_size steps are multiplied and only the product is tested.
+// If the product is a multiple of n, the steps are repeated one by one from the last tested value.
+// The sequence is computed in Montgomery form, which does not change the GCDs, since R is invertible modulo n.
+// From: Richard P. Brent, An improved Monte Carlo factorization algorithm (https://doi.org/10.1007/BF01933190).
+inline uint64_t pollard_rho_brent(uint64_t n)
+{
+    assert(n & 0x1);
+    assert(!is_prime(n));
+
+    const MontgomeryContext montgomery(n);
+    const size_t batch_size = 128;
+    const auto difference = [](uint64_t a, uint64_t b)
+    { return a > b ? a - b : b - a; };
+
+    for (uint64_t c = 1;; c++)
+    {
+        const uint64_t c_montgomery = montgomery.to_montgomery(c % n);
+        const auto step = [&](uint64_t x)
+        { return mod_add(montgomery.square(x), c_montgomery, n); };
+
+        uint64_t x = 0;
+        uint64_t y = montgomery.to_montgomery(2 % n);
+        uint64_t y_saved = y;
+        uint64_t product = montgomery.one();
+        uint64_t g = 1;
+        for (size_t r = 1; g == 1; r <<= 1)
+        {
+            x = y;
+            for (size_t i = 0; i < r; i++)
+            {
+                y = step(y);
+            }
+            for (size_t k = 0; k < r && g == 1; k += batch_size)
+            {
+                y_saved = y;
+                for (size_t i = 0; i < batch_size && i < r - k; i++)
+                {
+                    y = step(y);
+                    product = montgomery.multiply(product, difference(x, y));
+                }
+                g = std::gcd(product, n);
+            }
+        }
+        if (g == n)
+        {
+            do
+            {
+                y_saved = step(y_saved);
+                g = std::gcd(difference(x, y_saved), n);
+            } while (g == 1);
+        }
+        // g == n means that the cycles modulo all prime factors are equal, which is unlikely but possible.
+        if (g != n)
+        {
+            return g;
+        }
+    }
+}
+
+// Appends the prime factors of n to factors, n has no prime factor below 64.
+inline void factorize_large(uint64_t n, std::vector<uint64_t> &factors)
+{
+    if (n == 1)
+    {
+        return;
+    }
+    if (is_prime(n))
+    {
+        factors.push_back(n);
+        return;
+    }
+    const uint64_t d = pollard_rho_brent(n);
+    factorize_large(d, factors);
+    factorize_large(n / d, factors);
+}
+
+// Returns the prime factors of n > 0 in ascending order, every factor as often as it divides n.
+// The factors below 64 are found by trial division, the remaining ones with Pollard's rho algorithm,
+// which needs about sqrt(p) steps for the second largest prime factor p. The worst case is a product of two
+// 32 bit primes with about 2^16 steps.
+inline std::vector<uint64_t> factorize(uint64_t n)
+{
+    assert(n > 0);
+
+    std::vector<uint64_t> factors;
+    for (const uint64_t p : small_primes)
+    {
+        while (n % p == 0)
+        {
+            factors.push_back(p);
+            n /= p;
+        }
+    }
+    factorize_large(n, factors);
+    std::sort(factors.begin(), factors.end());
+    return factors;
+}
+
+// Returns Euler's totient function phi(n), the number of a in [1, n] with gcd(a, n) == 1
+// (https://en.wikipedia.org/wiki/Euler%27s_totient_function).
+// With n = p_1^e_1 * ... * p_k^e_k, phi(n) = p_1^(e_1 - 1) * (p_1 - 1) * ... * p_k^(e_k - 1) * (p_k - 1).
+inline uint64_t euler_phi(uint64_t n)
+{
+    uint64_t phi = 1;
+    const std::vector<uint64_t> factors = factorize(n);
+    for (size_t i = 0; i < factors.size(); i++)
+    {
+        phi *= (i > 0 && factors[i] == factors[i - 1]) ? factors[i] : factors[i] - 1;
+    }
+    return phi;
+}
+
+// Returns the Jacobi symbol (a/n) for odd n (https://en.wikipedia.org/wiki/Jacobi_symbol).
+// For a prime n, it is the Legendre symbol: 1 if a is a nonzero square modulo n, -1 if it is not and 0 if n divides a.
+// The algorithm works like the binary GCD: the factors 2 of a are removed with (2/n) = -1 for n % 8 == 3 or 5,
+// then a and n are swapped by quadratic reciprocity, which flips the sign if a % 4 == n % 4 == 3, and a is reduced
+// modulo n. Like the Euclidean algorithm, it needs O(log n) divisions.
+// From: Henri Cohen, A Course in Computational Algebraic Number Theory, algorithm 1.4.10.
+inline int jacobi_symbol(uint64_t a, uint64_t n)
+{
+    assert(n & 0x1);
+
+    a %= n;
+    int result = 1;
+    while (a != 0)
+    {
+        const int z = __builtin_ctzll(a);
+        a >>= z;
+        if ((z & 0x1) && ((n & 0x7) == 3 || (n & 0x7) == 5))
+        {
+            result = -result;
+        }
+        if ((a & 0x3) == 3 && (n & 0x3) == 3)
+        {
+            result = -result;
+        }
+        std::swap(a, n);
+        a %= n;
+    }
+    return n == 1 ? result : 0;
+}
+
+// Returns the Legendre symbol (a/p) for an odd prime p (https://en.wikipedia.org/wiki/Legendre_symbol).
+// By Euler's criterion, it is a^((p - 1) / 2) % p, but the Jacobi symbol needs fewer operations.
+inline int legendre_symbol(uint64_t a, uint64_t p)
+{
+    return jacobi_symbol(a, p);
+}
+
+// Computes square roots modulo a prime p (https://en.wikipedia.org/wiki/Quadratic_residue).
+// With p - 1 = q * 2^s and q odd, there are two algorithms:
+// - Tonelli-Shanks (https://en.wikipedia.org/wiki/Tonelli%E2%80%93Shanks_algorithm) needs one exponentiation
+//   with about 1.5 * log2(q) multiplications and on average about s^2 / 4 squarings to correct the root in the
+//   subgroup of order 2^s.
+// - Cipolla (https://en.wikipedia.org/wiki/Cipolla%27s_algorithm) computes (t + w)^((p + 1) / 2) in
+//   F_p(w) with w^2 = t^2 - a, which is independent of s, but costs about 6 * log2(p) multiplications.
+// So Tonelli-Shanks is used for small s, and Cipolla for the rare primes with s^2 > 16 * log2(p) (the measured
+// crossover), like NTT primes.
+// Neither algorithm needs a Legendre symbol to reject non-squares: for a non-square, b = a^q in Tonelli-Shanks has
+// the order 2^s, and the result of Cipolla's algorithm is no square root.
+// The non-square z and z^q for Tonelli-Shanks only depend on p, so they are computed once.
+// From: Henri Cohen, A Course in Computational Algebraic Number Theory, algorithms 1.5.1 and 1.5.4.
+class ModSqrtContext
+{
+public:
+    // p has to be a prime.
+    explicit ModSqrtContext(uint64_t p) : p(p), q(p - 1), s(0), z_q(1), use_cipolla(false)
+    {
+        assert(p > 1);
+
+        if (p == 2)
+        {
+            return;
+        }
+        s = __builtin_ctzll(q);
+        q >>= s;
+        const int bits = 64 - __builtin_clzll(p);
+        use_cipolla = s * s > 16 * bits;
+        // For s == 1, Tonelli-Shanks does not need z.
+        if (s > 1)
+        {
+            uint64_t z = 2;
+            while (legendre_symbol(z, p) != -1)
+            {
+                z++;
+            }
+            z_q = mod_power(z, q, p);
+        }
+    }
+
+    uint64_t modulus() const
+    {
+        return p;
+    }
+
+    // Returns true if sqrt uses Cipolla's algorithm.
+    bool uses_cipolla() const
+    {
+        return use_cipolla;
+    }
+
+    // Returns a square root x of a with x^2 % p == a, or std::nullopt if a is not a square modulo p.
+    // The other square root is p - x.
+    std::optional<uint64_t> sqrt(uint64_t a) const
+    {
+        assert(a < p);
+
+        if (a == 0 || p == 2)
+        {
+            return a;
+        }
+        return use_cipolla ? cipolla(a) : tonelli_shanks(a);
+    }
+
+    // Returns a square root of a != 0 with the Tonelli-Shanks algorithm, or std::nullopt if a is not a square.
+    // x = a^((q + 1) / 2) satisfies x^2 = a * b with b = a^q, which has an order 2^m with m < s for a square.
+    // Every iteration multiplies x with a power of z^q, which reduces the order of b.
+    std::optional<uint64_t> tonelli_shanks(uint64_t a) const
+    {
+        assert(p > 2 && a > 0 && a < p);
+
+        const uint64_t t = mod_power(a, q >> 1, p); // a^((q - 1) / 2)
+        uint64_t x = mod_multiply(a, t, p);
+        uint64_t b = mod_multiply(x, t, p);
+        uint64_t c = z_q;
+        int m = s;
+        while (b != 1)
+        {
+            // The order of b is 2^i.
+            int i = 1;
+            for (uint64_t b2 = mod_sqr(b, p); b2 != 1; b2 = mod_sqr(b2, p))
+            {
+                i++;
+            }
+            if (i == m)
+            {
+                return std::nullopt;
+            }
+            for (int j = i + 1; j < m; j++)
+            {
+                c = mod_sqr(c, p);
+            }
+            x = mod_multiply(x, c, p);
+            c = mod_sqr(c, p);
+            b = mod_multiply(b, c, p);
+            m = i;
+        }
+        return x;
+    }
+
+    // Returns a square root of a != 0 with Cipolla's algorithm, or std::nullopt if a is not a square.
+    // For t with a non-square d = t^2 - a, (t + w)^((p + 1) / 2) with w^2 = d is in F_p and a square root of a.
+    std::optional<uint64_t> cipolla(uint64_t a) const
+    {
+        assert(p > 2 && a > 0 && a < p);
+
+        // Half of all t < p work, so the search takes 2 steps on average.
+        uint64_t t = 0;
+        uint64_t d = p - a;
+        while (legendre_symbol(d, p) != -1)
+        {
+            t++;
+            d = mod_subtract(mod_sqr(t, p), a, p);
+        }
+
+        // Left to right exponentiation of x + y * w, starting with the top bit of e.
+        const uint64_t e = (p >> 1) + 1;
+        uint64_t x = t;
+        uint64_t y = 1;
+        for (int bit = 62 - __builtin_clzll(e); bit >= 0; bit--)
+        {
+            // (x + y * w)^2 = x^2 + y^2 * d + 2 * x * y * w
+            const uint64_t xy = mod_multiply(x, y, p);
+            x = mod_add(mod_sqr(x, p), mod_multiply(mod_sqr(y, p), d, p), p);
+            y = mod_add(xy, xy, p);
+            if ((e >> bit) & 0x1)
+            {
+                // (x + y * w) * (t + w) = x * t + y * d + (x + y * t) * w
+                const uint64_t x_next = mod_add(mod_multiply(x, t, p), mod_multiply(y, d, p), p);
+                y = mod_add(x, mod_multiply(y, t, p), p);
+                x = x_next;
+            }
+        }
+        if (y != 0 || mod_sqr(x, p) != a)
+        {
+            return std::nullopt;
+        }
+        return x;
+    }
+
+private:
+    uint64_t p;
+    uint64_t q;   // p - 1 = q * 2^s
+    int s;
+    uint64_t z_q; // z^q for a non-square z
+    bool use_cipolla;
+};
+
+// Returns a square root x of a modulo the prime p with x^2 % p == a, or std::nullopt if a is not a square modulo p.
+inline std::optional<uint64_t> mod_sqrt(uint64_t a, uint64_t p)
+{
+    return ModSqrtContext(p).sqrt(a);
+}
+
+// This function sets exists[i] and roots[i] to the square root of a[i] modulo the prime p for all i < len and
+// returns the number of squares. If a[i] is not a square, exists[i] is false and roots[i] is 0.
+// The context is computed only once, and the array is split into threads chunks like in is_prime_batch.
+inline size_t mod_sqrt_batch(const uint64_t *a, uint64_t *roots, bool *exists, size_t len, uint64_t p,
+                             size_t threads = std::thread::hardware_concurrency())
+{
+    threads = threads > 0 ? threads : 1;
+
+    const ModSqrtContext context(p);
+    const auto sqrt_range = [&context, a, roots, exists](size_t begin, size_t end)
+    {
+        size_t squares = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            const std::optional<uint64_t> root = context.sqrt(a[i]);
+            exists[i] = root.has_value();
+            roots[i] = root.value_or(0);
+            squares += exists[i];
+        }
+        return squares;
+    };
+
+    const size_t chunk = (len + threads - 1) / threads;
+    if (threads == 1 || chunk == 0)
+    {
+        return sqrt_range(0, len);
+    }
+
+    std::vector<size_t> squares(threads, 0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++)
+    {
+        const size_t begin = t * chunk < len ? t * chunk : len;
+        const size_t end = begin + chunk < len ? begin + chunk : len;
+        workers.emplace_back([=, &squares]()
+                             { squares[t] = sqrt_range(begin, end); });
+    }
+    size_t total = 0;
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers[t].join();
+        total += squares[t];
+    }
+    return total;
+}
+
+// Returns the multiplicative order of a modulo n, the smallest k > 0 with a^k % n == 1, or std::nullopt if
+// gcd(a, n) != 1 (https://en.wikipedia.org/wiki/Multiplicative_order).
+// The order divides phi(n), so it is found by removing the prime factors q of phi(n) as long as a^(order / q) == 1.
+inline std::optional<uint64_t> multiplicative_order(uint64_t a, uint64_t n)
+{
+    assert(n & 0x1);
+    assert(a < n);
+
+    if (std::gcd(a, n) != 1)
+    {
+        return std::nullopt;
+    }
+    const MontgomeryContext montgomery(n);
+    const uint64_t a_montgomery = montgomery.to_montgomery(a % n);
+    uint64_t order = euler_phi(n);
+    const std::vector<uint64_t> factors = factorize(order);
+    for (size_t i = 0; i < factors.size(); i++)
+    {
+        if (i > 0 && factors[i] == factors[i - 1])
+        {
+            continue;
+        }
+        while (order % factors[i] == 0 && montgomery.power(a_montgomery, order / factors[i]) == montgomery.one())
+        {
+            order /= factors[i];
+        }
+    }
+    return order;
+}
+
+// The default memory budget of BabyStepGiantStep in bytes.
+constexpr size_t discrete_log_memory_budget = 64 << 20;
+
+// Solves a^x == b (mod n) for a fixed base a with the baby-step giant-step algorithm
+// (https://en.wikipedia.org/wiki/Baby-step_giant-step).
+// With x = i * m + j and j < m, the equation becomes a^j == b * (a^-m)^i. The m baby steps a^j are stored in a hash
+// table, then the giant steps b * (a^-m)^i for i = 0, 1, ... are looked up until one is found. For the order
+// N of a, this needs m + N / m multiplications, which is minimal for m = sqrt(N).
+// The table is flat with open addressing and linear probing, so a lookup usually touches a single cache line. It has
+// at least twice as many slots as entries, which keeps the probe sequences short. The key 0 marks an empty slot,
+// which is no power of an invertible a. The table never exceeds the memory budget (apart from a minimum of two
+// slots); if the table of sqrt(N) entries does not fit, m is reduced and the giant steps take longer.
+// The table only depends on a, so it is reused for all b. The giant steps are split into threads ranges of i, and
+// every thread starts with its own b * (a^-m)^i.
+// All elements are in Montgomery form, so n has to be odd.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap3.pdf), algorithm 3.56.
+class BabyStepGiantStep
+{
+public:
+    // a has to be coprime to n, and order has to be the order of a or a multiple of it.
+    BabyStepGiantStep(uint64_t a, uint64_t n, uint64_t order, size_t memory_budget = discrete_log_memory_budget)
+        : montgomery(n), order(order)
+    {
+        assert(n & 0x1);
+        assert(a < n);
+        assert(order > 0);
+
+        // m = ceil(sqrt(order)).
+        uint64_t m = static_cast<uint64_t>(std::sqrt(static_cast<double>(order)));
+        while (m * m < order && m < (1UL << 32))
+        {
+            m++;
+        }
+        // The table has the smallest power of two >= 2 * m slots, but at most as many as fit into the memory budget
+        // (and at least 2). The baby steps fill at most half of the slots.
+        int bits = 1;
+        while ((1UL << bits) < 2 * m && (2UL << bits) * sizeof(Entry) <= memory_budget)
+        {
+            bits++;
+        }
+        step_count = std::min<uint64_t>(m, (1UL << bits) / 2);
+        giant_step_count = (order - 1) / step_count + 1;
+        shift = 64 - bits;
+        table.resize(1UL << bits);
+
+        const uint64_t a_montgomery = montgomery.to_montgomery(a);
+        uint64_t x = montgomery.one();
+        for (uint64_t j = 0; j < step_count; j++)
+        {
+            insert(x, j);
+            x = montgomery.multiply(x, a_montgomery);
+        }
+        const std::optional<uint64_t> a_inverse = mod_inverse(a, n);
+        assert(a_inverse);
+        giant_step = montgomery.power(montgomery.to_montgomery(*a_inverse), step_count);
+    }
+
+    // Returns the number of baby steps m.
+    uint64_t baby_steps() const
+    {
+        return step_count;
+    }
+
+    // Returns the number of giant steps for a b which is no power of a.
+    uint64_t giant_steps() const
+    {
+        return giant_step_count;
+    }
+
+    // Returns the smallest x with a^x % n == b, or std::nullopt if b is no power of a.
+    std::optional<uint64_t> log(uint64_t b, size_t threads = 1) const
+    {
+        assert(b < montgomery.modulus());
+
+        threads = std::max<size_t>(1, std::min<uint64_t>(threads, giant_step_count));
+        const uint64_t b_montgomery = montgomery.to_montgomery(b);
+        const uint64_t chunk = (giant_step_count - 1) / threads + 1;
+        // The smallest x found so far, the threads stop when their x cannot be smaller.
+        std::atomic<uint64_t> best(UINT64_MAX);
+        const auto search = [&](uint64_t begin, uint64_t end)
+        {
+            uint64_t y = montgomery.multiply(b_montgomery, montgomery.power(giant_step, begin));
+            for (uint64_t i = begin; i < end && i * step_count < best.load(std::memory_order_relaxed); i++)
+            {
+                const std::optional<uint64_t> j = find(y);
+                if (j)
+                {
+                    uint64_t x = i * step_count + *j;
+                    uint64_t current = best.load();
+                    while (x < current && !best.compare_exchange_weak(current, x))
+                    {
+                    }
+                    return;
+                }
+                y = montgomery.multiply(y, giant_step);
+            }
+        };
+
+        if (threads == 1)
+        {
+            search(0, giant_step_count);
+        }
+        else
+        {
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < threads; t++)
+            {
+                const uint64_t begin = std::min(t * chunk, giant_step_count);
+                const uint64_t end = std::min(begin + chunk, giant_step_count);
+                workers.emplace_back(search, begin, end);
+            }
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+        if (best == UINT64_MAX)
+        {
+            return std::nullopt;
+        }
+        return best.load();
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t key = 0; // a^j in Montgomery form, 0 for an empty slot
+        uint64_t j = 0;
+    };
+
+    size_t slot(uint64_t key) const
+    {
+        // Fibonacci hashing, the upper bits of the product depend on all bits of the key.
+        return static_cast<size_t>((key * 0x9e3779b97f4a7c15UL) >> shift);
+    }
+
+    // Keeps the smallest j for every key, the baby steps are inserted in ascending order.
+    void insert(uint64_t key, uint64_t j)
+    {
+        const size_t mask = table.size() - 1;
+        for (size_t i = slot(key);; i = (i + 1) & mask)
+        {
+            if (table[i].key == 0)
+            {
+                table[i] = {key, j};
+                return;
+            }
+            if (table[i].key == key)
+            {
+                return;
+            }
+        }
+    }
+
+    std::optional<uint64_t> find(uint64_t key) const
+    {
+        const size_t mask = table.size() - 1;
+        for (size_t i = slot(key);; i = (i + 1) & mask)
+        {
+            if (table[i].key == 0)
+            {
+                return std::nullopt;
+            }
+            if (table[i].key == key)
+            {
+                return table[i].j;
+            }
+        }
+    }
+
+    MontgomeryContext montgomery;
+    uint64_t order;
+    uint64_t step_count = 0;       // m
+    uint64_t giant_step_count = 0; // ceil(order / m)
+    uint64_t giant_step = 0;       // a^-m in Montgomery form
+    int shift = 0;
+    std::vector<Entry> table;
+};
+
+// Returns the smallest x with a^x % n == b, or std::nullopt if there is none
+// (https://en.wikipedia.org/wiki/Discrete_logarithm). n has to be odd, and a coprime to n.
+// The Pohlig-Hellman algorithm (https://en.wikipedia.org/wiki/Pohlig%E2%80%93Hellman_algorithm) splits the problem
+// along the factorization of the order N = q_1^e_1 * ... * q_k^e_k of a: x % q^e is found digit by digit with
+// e discrete logarithms in the subgroup of prime order q, which are solved with BabyStepGiantStep, and the
+// results are combined with the Chinese remainder theorem. So the work is about e * sqrt(q) for the largest
+// prime factor q instead of sqrt(N), which makes smooth orders fast. Since b might not be a power of a, the
+// result is checked at the end.
+// memory_budget limits the table of every BabyStepGiantStep, and threads is the number of threads of the giant steps.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap3.pdf), algorithm 3.63.
+inline std::optional<uint64_t> discrete_log(uint64_t a, uint64_t b, uint64_t n, size_t memory_budget = discrete_log_memory_budget,
+                                            size_t threads = std::thread::hardware_concurrency())
+{
+    assert(n & 0x1);
+    assert(a < n && b < n);
+
+    if (n == 1)
+    {
+        return 0;
+    }
+    const std::optional<uint64_t> order = multiplicative_order(a, n);
+    assert(order);
+    const MontgomeryContext montgomery(n);
+    const uint64_t a_montgomery = montgomery.to_montgomery(a);
+    const uint64_t b_montgomery = montgomery.to_montgomery(b);
+
+    const std::vector<uint64_t> factors = factorize(*order);
+    uint64_t x = 0;
+    uint64_t modulus = 1;
+    for (size_t i = 0; i < factors.size();)
+    {
+        const uint64_t q = factors[i];
+        int e = 0;
+        uint64_t q_e = 1;
+        for (; i < factors.size() && factors[i] == q; i++)
+        {
+            e++;
+            q_e *= q;
+        }
+
+        // a_q has the order q^e, and gamma = a_q^(q^(e-1)) the order q.
+        const uint64_t cofactor = *order / q_e;
+        const uint64_t a_q = montgomery.power(a_montgomery, cofactor);
+        const uint64_t b_q = montgomery.power(b_montgomery, cofactor);
+        const uint64_t a_q_inverse = montgomery.power(a_q, q_e - 1);
+        const uint64_t gamma = montgomery.power(a_q, q_e / q);
+        const BabyStepGiantStep solver(montgomery.from_montgomery(gamma), n, q, memory_budget);
+
+        // x_q = d_0 + d_1 * q + ... + d_(e-1) * q^(e-1), where d_k is the logarithm of
+        // (b_q * a_q^-(d_0 + ... + d_(k-1) * q^(k-1)))^(q^(e-1-k)) to the base gamma.
+        uint64_t x_q = 0;
+        uint64_t q_k = 1;
+        uint64_t h_base = b_q;
+        for (int k = 0; k < e; k++)
+        {
+            const uint64_t h = montgomery.power(h_base, q_e / q / q_k);
+            const std::optional<uint64_t> d = solver.log(montgomery.from_montgomery(h), threads);
+            if (!d)
+            {
+                return std::nullopt;
+            }
+            x_q += *d * q_k;
+            h_base = montgomery.multiply(h_base, montgomery.power(a_q_inverse, *d * q_k));
+            q_k *= q;
+        }
+
+        // x == x (mod modulus) and x == x_q (mod q^e).
+        const uint64_t modulus_inverse = mod_inverse(modulus % q_e, q_e).value();
+        const uint64_t t = mod_multiply(mod_subtract(x_q, x % q_e, q_e), modulus_inverse, q_e);
+        x += modulus * t;
+        modulus *= q_e;
+    }
+    if (montgomery.power(a_montgomery, x) != b_montgomery)
+    {
+        return std::nullopt;
+    }
+    return x;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <assert.h>
+
+#include "number_theory.h"
+
+// This code shows the number theoretic algorithms implemented in number_theory.h.
+
+// Returns is_composite[i] for all i < limit with the sieve of Eratosthenes.
+std::vector<bool> sieve(size_t limit)
+{
+    std::vector<bool> is_composite(limit, false);
+    for (size_t i = 2; i * i < limit; i++)
+    {
+        if (!is_composite[i])
+        {
+            for (size_t j = i * i; j < limit; j += i)
+            {
+                is_composite[j] = true;
+            }
+        }
+    }
+    return is_composite;
+}
+
+int main(int argc, char **argv)
+{
+    std::cout << "is_prime(18446744073709551557) = " << is_prime(18446744073709551557UL) << std::endl;
+    std::cout << "is_prime(18446744073709551559) = " << is_prime(18446744073709551559UL) << std::endl;
+    // A Carmichael number and a strong pseudoprime to all prime bases up to 23.
+    std::cout << "is_prime(3215031751) = " << is_prime(3215031751UL) << std::endl;
+    std::cout << "is_prime(3825123056546413051) = " << is_prime(3825123056546413051UL) << std::endl;
+    std::cout << "next_prime(10^18) = " << next_prime(1000000000000000000UL).value() << std::endl;
+    assert(is_prime(18446744073709551557UL));
+    assert(!is_prime(3215031751UL));
+    assert(!is_prime(3825123056546413051UL));
+    assert(next_prime(1000000000000000000UL).value() == 1000000000000000003UL);
+    assert(!next_prime(18446744073709551558UL));
+
+    const std::vector<bool> is_composite = sieve(1 << 16);
+    std::vector<uint64_t> candidates(is_composite.size());
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        candidates[i] = i;
+    }
+    const std::unique_ptr<bool[]> primes(new bool[candidates.size()]);
+    const size_t prime_count = is_prime_batch(candidates.data(), primes.get(), candidates.size(), 4);
+    for (size_t i = 2; i < candidates.size(); i++)
+    {
+        assert(primes[i] == !is_composite[i]);
+    }
+    std::cout << "Primes below 65536: " << prime_count << std::endl;
+    assert(prime_count == 6542);
+
+    const std::vector<uint64_t> factors = factorize(18446744073709551615UL);
+    std::cout << "factorize(18446744073709551615) =";
+    for (const uint64_t factor : factors)
+    {
+        std::cout << " " << factor;
+    }
+    std::cout << std::endl;
+    assert(factors == std::vector<uint64_t>({3, 5, 17, 257, 641, 65537, 6700417}));
+    // The product of the two largest 32 bit primes needs the most steps of Pollard's rho algorithm.
+    assert(factorize(4294967291UL * 4294967279UL) == std::vector<uint64_t>({4294967279UL, 4294967291UL}));
+    assert(factorize(1UL << 63) == std::vector<uint64_t>(63, 2));
+    std::cout << "euler_phi(12985254587577588852) = " << euler_phi(12985254587577588852UL) << std::endl;
+    assert(euler_phi(18446744073709551557UL) == 18446744073709551556UL);
+
+    // 2 is a square modulo p if p % 8 == 1 or 7.
+    std::cout << "legendre_symbol(2, 18446744073709551557) = " << legendre_symbol(2, 18446744073709551557UL) << std::endl;
+    assert(legendre_symbol(2, 18446744073709551557UL) == -1);
+    assert(jacobi_symbol(2, 15) == 1 && jacobi_symbol(7, 15) == -1 && jacobi_symbol(10, 15) == 0);
+
+    // Tonelli-Shanks for p - 1 = q * 2^2, Cipolla for p - 1 = 29 * 2^57.
+    for (const uint64_t p : {18446744073709551557UL, 4179340454199820289UL})
+    {
+        const uint64_t root = mod_sqrt(10, p).value_or(0);
+        std::cout << "mod_sqrt(10, " << p << ") = " << root << ", uses Cipolla: " << ModSqrtContext(p).uses_cipolla() << std::endl;
+        assert(mod_sqr(root, p) == 10);
+        assert(!mod_sqrt(3, p));
+    }
+
+    // mod_sqrt_batch agrees with the brute force search for all a < 1009.
+    const uint64_t p = 1009;
+    std::vector<uint64_t> squares(p);
+    for (uint64_t a = 0; a < p; a++)
+    {
+        squares[a] = a;
+    }
+    std::vector<uint64_t> roots(p);
+    const std::unique_ptr<bool[]> exists(new bool[p]);
+    const size_t square_count = mod_sqrt_batch(squares.data(), roots.data(), exists.get(), p, p, 4);
+    for (uint64_t a = 0; a < p; a++)
+    {
+        bool is_square = false;
+        for (uint64_t x = 0; x < p && !is_square; x++)
+        {
+            is_square = mod_sqr(x, p) == a;
+        }
+        assert(exists[a] == is_square);
+        assert(!exists[a] || mod_sqr(roots[a], p) == a);
+    }
+    std::cout << "Squares modulo 1009: " << square_count << std::endl;
+    assert(square_count == 505);
+
+    // 5 is a primitive root modulo 10^9 + 7, p - 1 = 2 * 500000003 needs baby-step giant-step with 22361 steps.
+    assert(multiplicative_order(5, 1000000007).value() == 1000000006);
+    const uint64_t x = discrete_log(5, 123456789, 1000000007).value();
+    std::cout << "discrete_log(5, 123456789, 1000000007) = " << x << std::endl;
+    assert(mod_power(5, x, 1000000007) == 123456789);
+
+    // p - 1 = 2^2 * 43 * 67 * 193 * 809383 * 10247197 is smooth enough for Pohlig-Hellman.
+    const uint64_t p64 = 18446744073709551533UL;
+    const uint64_t b = mod_power(2, 1234567890123456789UL, p64);
+    const uint64_t x64 = discrete_log(2, b, p64).value();
+    std::cout << "discrete_log(2, " << b << ", " << p64 << ") = " << x64 << std::endl;
+    assert(mod_power(2, x64, p64) == b);
+
+    // The powers of 4 are the squares modulo 1000000007, 5 is none of them.
+    assert(!discrete_log(4, 5, 1000000007));
+    // A composite modulus, where 2 has the order 120, and a memory budget for 2 baby steps.
+    const uint64_t n = 3 * 5 * 7 * 11 * 13 * 17;
+    assert(multiplicative_order(2, n).value() == 120);
+    const BabyStepGiantStep solver(2, n, 120, 64);
+    assert(solver.baby_steps() == 2 && solver.giant_steps() == 60);
+    assert(solver.log(mod_power(2, 100, n), 3).value() == 100);
+}
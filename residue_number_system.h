@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+
+// Residue number system (https://en.wikipedia.org/wiki/Residue_number_system).
+// For pairwise coprime moduli m_0, ..., m_(k-1), a number 0 <= x < M = m_0 * ... * m_(k-1) is represented by its
+// residues x % m_0, ..., x % m_(k-1). By the Chinese remainder theorem, this representation is unique, and
+// addition, subtraction and multiplication modulo M work independently on every residue ("lane").
+// So a number with k * 64 bits is processed as k independent word sized operations without carries between lanes.
+// The loops over the lanes have no dependencies between iterations, so the CPU can overlap the lanes.
+//
+// The number is reconstructed from the residues with Garner's algorithm, which computes the mixed radix digits
+// v_0, ..., v_(k-1) with x = v_0 + v_1 * m_0 + v_2 * m_0 * m_1 + ... + v_(k-1) * m_0 * ... * m_(k-2) and v_i < m_i.
+// It needs the precomputed inverses (m_0 * ... * m_(j-1))^-1 % m_j, which are computed with
+// extended_greatest_common_divisor, so the moduli have to be below 2^63.
+// From: Handbook of Applied Cryptography (https://cacr.uwaterloo.ca/hac/about/chap14.pdf), chapter 14.5.2.
+class RNSContext
+{
+public:
+    // The moduli have to be pairwise coprime, greater than 1 and smaller than 2^63.
+    explicit RNSContext(const std::vector<uint64_t> &moduli)
+        : lane_moduli(moduli), garner_inverses(moduli.size()), moduli_mod(moduli.size() * moduli.size())
+    {
+        assert(!moduli.empty());
+
+        const size_t k = moduli.size();
+        for (size_t j = 0; j < k; j++)
+        {
+            const uint64_t m_j = moduli[j];
+            assert(m_j > 1 && m_j < (1UL << 63));
+
+            for (size_t i = 0; i < k; i++)
+            {
+                moduli_mod[j * k + i] = moduli[i] % m_j;
+            }
+
+            // (m_0 * ... * m_(j-1)) % m_j and its inverse.
+            uint64_t product = 1 % m_j;
+            for (size_t i = 0; i < j; i++)
+            {
+                product = mod_multiply(product, moduli_mod[j * k + i], m_j);
+            }
+            int64_t tu1 = 0;
+            int64_t tu2 = 0;
+            const uint64_t gcd = extended_greatest_common_divisor(static_cast<int64_t>(product), static_cast<int64_t>(m_j), tu1, tu2);
+            assert(gcd == 1);
+            (void)gcd;
+            garner_inverses[j] = tu1 < 0 ? static_cast<uint64_t>(tu1 + static_cast<int64_t>(m_j)) : static_cast<uint64_t>(tu1);
+        }
+    }
+
+    const std::vector<uint64_t> &moduli() const
+    {
+        return lane_moduli;
+    }
+
+    // Returns the number of lanes k.
+    size_t size() const
+    {
+        return lane_moduli.size();
+    }
+
+    // Writes the size() residues of x to residues.
+    void to_rns(uint64_t x, uint64_t *residues) const
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            residues[i] = x % lane_moduli[i];
+        }
+    }
+
+    // Returns the residues of x.
+    std::vector<uint64_t> to_rns(uint64_t x) const
+    {
+        std::vector<uint64_t> residues(size());
+        to_rns(x, residues.data());
+        return residues;
+    }
+
+    // The following operations work on arrays of size() residues and write the result to c without allocating, so
+    // they can be used in loops. c may be the same array as a or b.
+
+    // Computes the residues of (a + b) % M.
+    void add(const uint64_t *a, const uint64_t *b, uint64_t *c) const
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            c[i] = mod_add(a[i], b[i], lane_moduli[i]);
+        }
+    }
+
+    // Computes the residues of (a - b) % M.
+    void subtract(const uint64_t *a, const uint64_t *b, uint64_t *c) const
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            c[i] = mod_subtract(a[i], b[i], lane_moduli[i]);
+        }
+    }
+
+    // Computes the residues of (a * b) % M.
+    void multiply(const uint64_t *a, const uint64_t *b, uint64_t *c) const
+    {
+        for (size_t i = 0; i < size(); i++)
+        {
+            c[i] = mod_multiply(a[i], b[i], lane_moduli[i]);
+        }
+    }
+
+    // Returns the residues of (a + b) % M.
+    std::vector<uint64_t> add(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) const
+    {
+        assert(a.size() == size() && b.size() == size());
+
+        std::vector<uint64_t> c(size());
+        add(a.data(), b.data(), c.data());
+        return c;
+    }
+
+    // Returns the residues of (a - b) % M.
+    std::vector<uint64_t> subtract(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) const
+    {
+        assert(a.size() == size() && b.size() == size());
+
+        std::vector<uint64_t> c(size());
+        subtract(a.data(), b.data(), c.data());
+        return c;
+    }
+
+    // Returns the residues of (a * b) % M.
+    std::vector<uint64_t> multiply(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) const
+    {
+        assert(a.size() == size() && b.size() == size());
+
+        std::vector<uint64_t> c(size());
+        multiply(a.data(), b.data(), c.data());
+        return c;
+    }
+
+    // Returns the mixed radix digits v_0, ..., v_(k-1) of the number with the given residues (Garner's algorithm).
+    // v_j is determined from x == v_0 + ... + v_j * m_0 * ... * m_(j-1) (mod m_j), which needs O(k^2) operations.
+    std::vector<uint64_t> mixed_radix(const std::vector<uint64_t> &residues) const
+    {
+        assert(residues.size() == size());
+
+        const size_t k = size();
+        std::vector<uint64_t> digits(k);
+        for (size_t j = 0; j < k; j++)
+        {
+            const uint64_t m_j = lane_moduli[j];
+            const uint64_t *m_mod_j = moduli_mod.data() + j * k;
+            // (v_0 + v_1 * m_0 + ... + v_(j-1) * m_0 * ... * m_(j-2)) % m_j with the Horner scheme.
+            uint64_t sum = 0;
+            for (size_t i = j; i-- > 0;)
+            {
+                sum = mod_add(mod_multiply(sum, m_mod_j[i], m_j), digits[i] % m_j, m_j);
+            }
+            digits[j] = mod_multiply(mod_subtract(residues[j], sum, m_j), garner_inverses[j], m_j);
+        }
+        return digits;
+    }
+
+    // Returns the number with the given residues as little endian 64 bit limbs, the number of limbs is
+    // size() (enough for M < 2^(64 * k)).
+    std::vector<uint64_t> reconstruct(const std::vector<uint64_t> &residues) const
+    {
+        const std::vector<uint64_t> digits = mixed_radix(residues);
+        const size_t k = size();
+
+        // x = (...(v_(k-1) * m_(k-2) + v_(k-2)) * m_(k-3) + ...) * m_0 + v_0
+        std::vector<uint64_t> limbs(k, 0);
+        limbs[0] = digits[k - 1];
+        for (size_t i = k - 1; i-- > 0;)
+        {
+            uint64_t carry = digits[i];
+            for (size_t l = 0; l < k; l++)
+            {
+                const unsigned __int128 t = static_cast<unsigned __int128>(limbs[l]) * lane_moduli[i] + carry;
+                limbs[l] = static_cast<uint64_t>(t);
+                carry = static_cast<uint64_t>(t >> 64);
+            }
+            assert(carry == 0);
+        }
+        return limbs;
+    }
+
+    // Returns x % n for the number x with the given residues, without reconstructing x.
+    uint64_t reconstruct_mod(const std::vector<uint64_t> &residues, uint64_t n) const
+    {
+        assert(n > 0);
+
+        const std::vector<uint64_t> digits = mixed_radix(residues);
+        uint64_t x = 0;
+        for (size_t i = size(); i-- > 0;)
+        {
+            x = mod_add(mod_multiply(x, lane_moduli[i] % n, n), digits[i] % n, n);
+        }
+        return x;
+    }
+
+private:
+    std::vector<uint64_t> lane_moduli;
+    std::vector<uint64_t> garner_inverses; // (m_0 * ... * m_(j-1))^-1 % m_j
+    std::vector<uint64_t> moduli_mod;      // m_i % m_j at j * k + i
+};
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <vector>
+#include <assert.h>
+
+#include "residue_number_system.h"
+
+// This code shows how to compute with numbers larger than 64 bits in a residue number system.
+// The residue number system is implemented in residue_number_system.h.
+
+int main(int argc, char **argv)
+{
+    // Four primes below 2^63, M has about 250 bits.
+    const RNSContext rns({9223372036854775783UL, 9223372036854775643UL, 9223372036854775549UL, 9223372036854775507UL});
+
+    // 30! has 108 bits, every lane computes 30! modulo its own modulus.
+    // The loop multiplies in place and reuses the residues of i, so it does not allocate.
+    std::vector<uint64_t> factorial = rns.to_rns(1);
+    std::vector<uint64_t> residues_i(rns.size());
+    unsigned __int128 expected = 1;
+    for (uint64_t i = 2; i <= 30; i++)
+    {
+        rns.to_rns(i, residues_i.data());
+        rns.multiply(factorial.data(), residues_i.data(), factorial.data());
+        expected *= i;
+    }
+    const std::vector<uint64_t> limbs = rns.reconstruct(factorial);
+    std::cout << "30! = " << limbs[1] << " * 2^64 + " << limbs[0] << std::endl;
+    assert(limbs[0] == static_cast<uint64_t>(expected) && limbs[1] == static_cast<uint64_t>(expected >> 64));
+    assert(limbs[2] == 0 && limbs[3] == 0);
+
+    // 30! - 29! = 29 * 29!
+    std::vector<uint64_t> factorial_29 = rns.to_rns(1);
+    for (uint64_t i = 2; i <= 29; i++)
+    {
+        factorial_29 = rns.multiply(factorial_29, rns.to_rns(i));
+    }
+    const std::vector<uint64_t> difference = rns.subtract(factorial, factorial_29);
+    assert(difference == rns.multiply(factorial_29, rns.to_rns(29)));
+    assert(rns.add(difference, factorial_29) == factorial);
+
+    std::cout << "30! % 1000000007 = " << rns.reconstruct_mod(factorial, 1000000007) << std::endl;
+    assert(rns.reconstruct_mod(factorial, 1000000007) == static_cast<uint64_t>(expected % 1000000007));
+}
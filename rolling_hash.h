@@ -0,0 +1,392 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <assert.h>
+
+#include "modular_arithmetic.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ROLLING_HASH_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Polynomial rolling hash (https://en.wikipedia.org/wiki/Rolling_hash), as used by the Rabin-Karp string search
+// (Richard M. Karp and Michael O. Rabin, Efficient randomized pattern-matching algorithms,
+// https://doi.org/10.1147/rd.312.0249).
+// The hash of the bytes s[0], ..., s[len - 1] is s[0] * B^(len - 1) + s[1] * B^(len - 2) + ... + s[len - 1] mod n for
+// a base B. The modulus n is given by a modulus policy (see MersenneModulus), so every reduction is a few shifts and
+// additions instead of a division.
+//
+// Appending a byte c is hash * B + c. Sliding a window of w bytes by one byte removes out * B^w, so
+// hash * B + in - out * B^w is computed with one multiplication and one reduction, where -out * B^w comes from a
+// table of all 256 bytes.
+// Appending a block of k bytes unrolls Horner's rule into hash * B^k + s[0] * B^(k - 1) + ... + s[k - 1] with the
+// precomputed powers of B. The k products are independent and their 128 bit sum is reduced once, so only one
+// reduction per block is on the dependency chain of the hash.
+// Two strings of length len with different hashes are different. Equal hashes of different strings happen with a
+// probability of at most len / n for a random base, so DoubleRollingHash combines two moduli.
+template <class Modulus = MersenneModulus<61>>
+class RollingHash
+{
+public:
+    using value_type = uint64_t;
+
+    // The number of bytes which are appended at once by append_block.
+    static constexpr size_t block_size = 16;
+
+    // The base of the hashes, unless another one is given. Fingerprints can be compared only if they use the same
+    // base, a random base makes collisions unlikely for adversarial inputs.
+    static constexpr uint64_t default_base = 0x9e3779b97f4a7c15UL % Modulus::modulus;
+
+    // window is the number of bytes of the windows for slide and window_hashes.
+    explicit RollingHash(size_t window = 0, uint64_t base = default_base)
+        : b(base), w(window)
+    {
+        assert(base > 1 && base < Modulus::modulus);
+
+        powers[0] = 1;
+        for (size_t i = 1; i <= block_size; i++)
+        {
+            powers[i] = Modulus::multiply(powers[i - 1], b);
+        }
+        const uint64_t window_power = mod_power<Modulus>(b, w);
+        for (size_t c = 0; c < 256; c++)
+        {
+            removals[c] = mod_additive_inverse(Modulus::multiply(c % Modulus::modulus, window_power), Modulus::modulus);
+        }
+    }
+
+    uint64_t base() const
+    {
+        return b;
+    }
+
+    size_t window() const
+    {
+        return w;
+    }
+
+    // Returns the hash of the bytes of hash followed by the byte c.
+    uint64_t append(uint64_t hash, uint8_t c) const
+    {
+        return Modulus::reduce(static_cast<unsigned __int128>(hash) * b + c);
+    }
+
+    // Returns the hash of the bytes of hash followed by the block_size bytes at data.
+    uint64_t append_block(uint64_t hash, const uint8_t *data) const
+    {
+        unsigned __int128 sum = 0;
+        for (size_t i = 0; i < block_size; i++)
+        {
+            sum += static_cast<unsigned __int128>(powers[block_size - 1 - i]) * data[i];
+        }
+        // The sum of the products is smaller than 255 * block_size * n, for a modulus close to 2^64 it is reduced
+        // separately, so that the total does not overflow 128 bits.
+        if constexpr (single_reduction)
+        {
+            return Modulus::reduce(static_cast<unsigned __int128>(hash) * powers[block_size] + sum);
+        }
+        else
+        {
+            return Modulus::reduce(static_cast<unsigned __int128>(hash) * powers[block_size] + Modulus::reduce(sum));
+        }
+    }
+
+    // Returns the hash of the bytes of hash followed by the len bytes at data.
+    uint64_t append(uint64_t hash, const uint8_t *data, size_t len) const
+    {
+        size_t i = 0;
+        for (; i + block_size <= len; i += block_size)
+        {
+            hash = append_block(hash, data + i);
+        }
+        for (; i < len; i++)
+        {
+            hash = append(hash, data[i]);
+        }
+        return hash;
+    }
+
+    // Returns the hash of the len bytes at data.
+    uint64_t hash(const uint8_t *data, size_t len) const
+    {
+        return append(0, data, len);
+    }
+
+    // Returns the hash of the window s[1], ..., s[w - 1], in for the hash of the window s[0] = out, ..., s[w - 1].
+    uint64_t slide(uint64_t hash, uint8_t out, uint8_t in) const
+    {
+        assert(w > 0);
+        return Modulus::reduce(static_cast<unsigned __int128>(hash) * b + in + removals[out]);
+    }
+
+    // Computes the hashes of all len - window + 1 windows of the len bytes at data, hashes[i] is the hash of
+    // data[i], ..., data[i + window - 1].
+    // Every slide depends on the previous one, so the windows are split into lanes ranges, which start with their
+    // own hash and are slid in the same loop. This hides the latency of the multiplication and the reduction.
+    void window_hashes(const uint8_t *data, size_t len, uint64_t *hashes) const
+    {
+        assert(w > 0);
+        if (len < w)
+        {
+            return;
+        }
+        constexpr size_t lanes = 4;
+        const size_t count = len - w + 1;
+        // Short inputs are not split, since every lane hashes its first window from scratch.
+        const size_t lane_count = count < lanes * w ? count : count / lanes;
+        const size_t used_lanes = count < lanes * w ? 1 : lanes;
+        uint64_t lane_hashes[lanes];
+        for (size_t lane = 0; lane < used_lanes; lane++)
+        {
+            lane_hashes[lane] = this->hash(data + lane * lane_count, w);
+            hashes[lane * lane_count] = lane_hashes[lane];
+        }
+        for (size_t i = 1; i < lane_count; i++)
+        {
+            for (size_t lane = 0; lane < used_lanes; lane++)
+            {
+                const size_t j = lane * lane_count + i;
+                lane_hashes[lane] = slide(lane_hashes[lane], data[j - 1], data[j + w - 1]);
+                hashes[j] = lane_hashes[lane];
+            }
+        }
+        // The windows which are left over by the lanes.
+        uint64_t hash = lane_hashes[used_lanes - 1];
+        for (size_t j = used_lanes * lane_count; j < count; j++)
+        {
+            hash = slide(hash, data[j - 1], data[j + w - 1]);
+            hashes[j] = hash;
+        }
+    }
+
+private:
+    // Whether hash * B^block_size + 255 * block_size * (n - 1) fits into 128 bits.
+    static constexpr bool single_reduction = static_cast<unsigned __int128>(255 * block_size) * (Modulus::modulus - 1) <=
+                                             ~static_cast<unsigned __int128>(0) - static_cast<unsigned __int128>(Modulus::modulus - 1) * (Modulus::modulus - 1);
+
+    uint64_t b = 0;
+    size_t w = 0;
+    std::array<uint64_t, block_size + 1> powers{}; // B^i
+    std::array<uint64_t, 256> removals{};          // -c * B^w % n
+};
+
+// Two rolling hashes with different moduli, the hash is the pair of both hashes.
+// A collision needs a collision of both hashes, which happens with a probability of at most len^2 / (n_1 * n_2) for
+// random bases. Both hashes are updated in the same loop, so their dependency chains overlap.
+template <class Modulus1 = MersenneModulus<61>, class Modulus2 = PseudoMersenneModulus<59>>
+class DoubleRollingHash
+{
+public:
+    using value_type = std::pair<uint64_t, uint64_t>;
+
+    explicit DoubleRollingHash(size_t window = 0, uint64_t base1 = RollingHash<Modulus1>::default_base, uint64_t base2 = RollingHash<Modulus2>::default_base)
+        : first(window, base1), second(window, base2)
+    {
+    }
+
+    size_t window() const
+    {
+        return first.window();
+    }
+
+    value_type append(const value_type &hash, uint8_t c) const
+    {
+        return {first.append(hash.first, c), second.append(hash.second, c)};
+    }
+
+    value_type append(value_type hash, const uint8_t *data, size_t len) const
+    {
+        constexpr size_t block_size = RollingHash<Modulus1>::block_size;
+        static_assert(block_size == RollingHash<Modulus2>::block_size);
+        size_t i = 0;
+        for (; i + block_size <= len; i += block_size)
+        {
+            hash.first = first.append_block(hash.first, data + i);
+            hash.second = second.append_block(hash.second, data + i);
+        }
+        return {first.append(hash.first, data + i, len - i), second.append(hash.second, data + i, len - i)};
+    }
+
+    value_type hash(const uint8_t *data, size_t len) const
+    {
+        return append(value_type{0, 0}, data, len);
+    }
+
+    value_type slide(const value_type &hash, uint8_t out, uint8_t in) const
+    {
+        return {first.slide(hash.first, out, in), second.slide(hash.second, out, in)};
+    }
+
+    void window_hashes(const uint8_t *data, size_t len, value_type *hashes) const
+    {
+        assert(window() > 0);
+        if (len < window())
+        {
+            return;
+        }
+        value_type hash = this->hash(data, window());
+        hashes[0] = hash;
+        for (size_t i = window(); i < len; i++)
+        {
+            hash = slide(hash, data[i - window()], data[i]);
+            hashes[i - window() + 1] = hash;
+        }
+    }
+
+private:
+    RollingHash<Modulus1> first;
+    RollingHash<Modulus2> second;
+};
+
+// Returns the positions of all occurrences of the pattern in the text with the Rabin-Karp algorithm.
+// The hash of every window of the text is compared to the hash of the pattern, and equal hashes are verified, so
+// the result is exact.
+inline std::vector<size_t> rabin_karp_search(const uint8_t *text, size_t text_len, const uint8_t *pattern, size_t pattern_len)
+{
+    std::vector<size_t> positions;
+    if (pattern_len == 0 || pattern_len > text_len)
+    {
+        return positions;
+    }
+    const RollingHash<> hasher(pattern_len);
+    const uint64_t pattern_hash = hasher.hash(pattern, pattern_len);
+    uint64_t hash = hasher.hash(text, pattern_len);
+    for (size_t i = 0;; i++)
+    {
+        if (hash == pattern_hash && std::memcmp(text + i, pattern, pattern_len) == 0)
+        {
+            positions.push_back(i);
+        }
+        if (i + pattern_len == text_len)
+        {
+            break;
+        }
+        hash = hasher.slide(hash, text[i], text[i + pattern_len]);
+    }
+    return positions;
+}
+
+#if defined(ROLLING_HASH_MMAP)
+// A file mapped read only into memory. The pages are read from disk when they are accessed and can be dropped by
+// the kernel at any time, so files larger than the memory can be processed as one array.
+// The mapping stays valid as long as a copy of the MappedFile exists.
+class MappedFile
+{
+public:
+    // Maps the file at path, or returns std::nullopt if it can not be opened or is no regular file. Pipes, FIFOs
+    // and devices have no size that could be mapped.
+    // sequential tells the kernel that the file is read from front to back, so it reads ahead.
+    static std::optional<MappedFile> open(const std::string &path, bool sequential = true)
+    {
+        // Checked before opening, because opening a FIFO blocks until a writer opens it, and closing it again
+        // would make the writer fail.
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0 || !S_ISREG(status.st_mode))
+        {
+            return std::nullopt;
+        }
+        const int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            return std::nullopt;
+        }
+        if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode))
+        {
+            close(descriptor);
+            return std::nullopt;
+        }
+        MappedFile file;
+        file.file_size = static_cast<size_t>(status.st_size);
+        if (file.file_size > 0)
+        {
+            void *address = mmap(nullptr, file.file_size, PROT_READ, MAP_SHARED, descriptor, 0);
+            if (address == MAP_FAILED)
+            {
+                close(descriptor);
+                return std::nullopt;
+            }
+            if (sequential)
+            {
+                madvise(address, file.file_size, MADV_SEQUENTIAL);
+            }
+            const size_t size = file.file_size;
+            file.mapping = std::shared_ptr<const void>(address, [size](const void *a)
+                                                       { munmap(const_cast<void *>(a), size); });
+        }
+        close(descriptor);
+        return file;
+    }
+
+    const uint8_t *data() const
+    {
+        return static_cast<const uint8_t *>(mapping.get());
+    }
+
+    size_t size() const
+    {
+        return file_size;
+    }
+
+private:
+    MappedFile() = default;
+
+    std::shared_ptr<const void> mapping;
+    size_t file_size = 0;
+};
+#endif
+
+// Returns the hash of the bytes read from stream until its end, or std::nullopt if reading fails.
+// Hash is RollingHash or DoubleRollingHash.
+template <class Hash>
+std::optional<typename Hash::value_type> hash_stream(const Hash &hasher, std::istream &stream)
+{
+    // A multiple of the block size, so that the chunks are appended with full blocks.
+    std::vector<char> chunk(1 << 20);
+    typename Hash::value_type hash{};
+    while (stream)
+    {
+        stream.read(chunk.data(), chunk.size());
+        hash = hasher.append(hash, reinterpret_cast<const uint8_t *>(chunk.data()), static_cast<size_t>(stream.gcount()));
+    }
+    if (stream.bad())
+    {
+        return std::nullopt;
+    }
+    return hash;
+}
+
+// Returns the hash of the content of the file at path, or std::nullopt if it can not be read.
+// Hash is RollingHash or DoubleRollingHash. The file is mapped into memory if possible, otherwise (pipes, FIFOs,
+// devices, or no mmap) it is read in chunks. Empty mappings are read in chunks as well, because some special files
+// (e.g. in /proc) report the size 0.
+template <class Hash>
+std::optional<typename Hash::value_type> hash_file(const Hash &hasher, const std::string &path)
+{
+#if defined(ROLLING_HASH_MMAP)
+    const std::optional<MappedFile> mapped = MappedFile::open(path);
+    if (mapped && mapped->size() > 0)
+    {
+        return hasher.hash(mapped->data(), mapped->size());
+    }
+#endif
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+    return hash_stream(hasher, file);
+}
@@ -0,0 +1,114 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <assert.h>
+
+#include "rolling_hash.h"
+
+// This code shows how to fingerprint byte streams with a polynomial rolling hash and how to search with Rabin-Karp.
+// The rolling hashes are implemented in rolling_hash.h.
+
+// Computes the hash with one mod_multiply and one mod_add per byte.
+uint64_t hash_naive(const uint8_t *data, size_t len, uint64_t base, uint64_t n)
+{
+    uint64_t hash = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = mod_add(mod_multiply(hash, base, n), data[i] % n, n);
+    }
+    return hash;
+}
+
+int main(int argc, char **argv)
+{
+    const std::string text = "The quick brown fox jumps over the lazy dog, the lazy dog sleeps, the fox jumps again.";
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(text.data());
+    const RollingHash<> hasher;
+    std::cout << "Hash modulo 2^61 - 1 of \"" << text << "\" = " << hasher.hash(bytes, text.size()) << std::endl;
+
+    // The block updates, the bytewise updates and the naive loop give the same hashes for every length.
+    std::mt19937_64 generator(42);
+    std::vector<uint8_t> data(1000);
+    for (uint8_t &c : data)
+    {
+        c = static_cast<uint8_t>(generator());
+    }
+    const DoubleRollingHash<> double_hasher;
+    const RollingHash<PseudoMersenneModulus<59>> pseudo_mersenne_hasher;
+    for (size_t len = 0; len <= data.size(); len += 37)
+    {
+        uint64_t bytewise = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            bytewise = hasher.append(bytewise, data[i]);
+        }
+        const uint64_t expected = hash_naive(data.data(), len, hasher.base(), MersenneModulus<61>::modulus);
+        assert(hasher.hash(data.data(), len) == expected && bytewise == expected);
+        assert(pseudo_mersenne_hasher.hash(data.data(), len) == hash_naive(data.data(), len, pseudo_mersenne_hasher.base(), PseudoMersenneModulus<59>::modulus));
+        assert(double_hasher.hash(data.data(), len) == std::make_pair(expected, pseudo_mersenne_hasher.hash(data.data(), len)));
+    }
+
+    // Sliding a window gives the hash of the window.
+    const size_t window = 48;
+    const RollingHash<> window_hasher(window);
+    const DoubleRollingHash<> double_window_hasher(window);
+    std::vector<uint64_t> hashes(data.size() - window + 1);
+    std::vector<DoubleRollingHash<>::value_type> double_hashes(data.size() - window + 1);
+    window_hasher.window_hashes(data.data(), data.size(), hashes.data());
+    double_window_hasher.window_hashes(data.data(), data.size(), double_hashes.data());
+    for (size_t i = 0; i < hashes.size(); i++)
+    {
+        assert(hashes[i] == hasher.hash(data.data() + i, window));
+        assert(double_hashes[i] == double_hasher.hash(data.data() + i, window));
+    }
+    std::cout << "Hash of the last window of " << window << " bytes = " << hashes.back() << std::endl;
+
+    // Rabin-Karp finds the same positions as std::string::find.
+    for (const std::string pattern : {"the", "lazy dog", "fox jumps", "cat", "."})
+    {
+        const std::vector<size_t> positions = rabin_karp_search(bytes, text.size(), reinterpret_cast<const uint8_t *>(pattern.data()), pattern.size());
+        std::vector<size_t> expected;
+        for (size_t i = text.find(pattern); i != std::string::npos; i = text.find(pattern, i + 1))
+        {
+            expected.push_back(i);
+        }
+        assert(positions == expected);
+        std::cout << "Rabin-Karp: \"" << pattern << "\" found " << positions.size() << " times" << std::endl;
+    }
+
+    // The hash of a file is the hash of its content.
+    const std::string path = (std::filesystem::temp_directory_path() / "rolling_hash_main.bin").string();
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(data.data()), data.size());
+    const std::optional<uint64_t> file_hash = hash_file(hasher, path);
+    assert(file_hash && *file_hash == hasher.hash(data.data(), data.size()));
+    assert(hash_file(double_hasher, path) == double_hasher.hash(data.data(), data.size()));
+    std::cout << "Hash of " << path << " = " << *file_hash << std::endl;
+    std::remove(path.c_str());
+    assert(!hash_file(hasher, path));
+
+    // Streams and files that can not be mapped are read in chunks.
+    std::istringstream stream(std::string(data.begin(), data.end()));
+    assert(hash_stream(hasher, stream) == hasher.hash(data.data(), data.size()));
+#if defined(ROLLING_HASH_MMAP)
+    const std::string fifo_path = (std::filesystem::temp_directory_path() / "rolling_hash_main.fifo").string();
+    std::remove(fifo_path.c_str());
+    const bool fifo_created = mkfifo(fifo_path.c_str(), 0600) == 0;
+    assert(fifo_created);
+    if (fifo_created)
+    {
+        std::thread writer([&]()
+                           { std::ofstream(fifo_path, std::ios::binary).write(reinterpret_cast<const char *>(data.data()), data.size()); });
+        const std::optional<uint64_t> fifo_hash = hash_file(hasher, fifo_path);
+        writer.join();
+        std::remove(fifo_path.c_str());
+        assert(fifo_hash && *fifo_hash == hasher.hash(data.data(), data.size()));
+        std::cout << "Hash of the FIFO " << fifo_path << " = " << fifo_hash.value_or(0) << std::endl;
+    }
+#endif
+}